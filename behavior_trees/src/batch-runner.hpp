@@ -0,0 +1,106 @@
+#pragma once
+#include "common.hpp"
+#include "entity-pool.hpp"
+#include "world.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "job-system.hpp"
+
+// Many independent simulations in one process: every instance owns its World, EntityPool and
+// Rng streams, and only shares the (read-only) tree. A World keeps all of its state in members,
+// so instances can run side by side on different threads.
+//
+// Instances are spread over a JobSystem, one chunk each. Instance i is seeded from
+// (seed, i) alone, so its result does not depend on the thread count or on which
+// other instances ran in the same batch.
+
+struct BatchConfig final{
+    std::size_t instances = 1000;
+    std::size_t agents = 100;      //per instance
+    int frames = 600;
+    float dt = 1.0f / 60.0f;
+    std::uint64_t seed = 1;
+    Tuning tuning;                 //the same for every instance
+};
+
+// What one instance did over the whole run, in agent-seconds per activity.
+struct InstanceStats final{
+    std::uint64_t seed = 0;
+    std::uint32_t food_eaten = 0;
+    double caught_seconds = 0.0;  //within World::catch_radius of the active wolf
+    double flee_seconds = 0.0;
+    double seek_food_seconds = 0.0;
+    double patrol_seconds = 0.0;
+    double agent_seconds = 0.0;   //agents * simulated time
+};
+
+struct BatchStats final{
+    std::vector<InstanceStats> instances;
+    double wall_ns = 0.0;
+
+    struct Summary final{
+        double mean = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    // Summary over the instances of any per-instance value, e.g. fraction(&InstanceStats::flee_seconds).
+    template <typename Fn>
+    Summary summarize(Fn value) const noexcept{
+        if(instances.empty()) return {};
+        Summary s{0.0, std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+        for(const auto& i : instances){
+            const double v = value(i);
+            s.mean += v;
+            s.min = std::min(s.min, v);
+            s.max = std::max(s.max, v);
+        }
+        s.mean /= static_cast<double>(instances.size());
+        return s;
+    }
+
+    static auto fraction(double InstanceStats::* field) noexcept{
+        return [field](const InstanceStats& i){ return (i.agent_seconds > 0.0) ? i.*field / i.agent_seconds : 0.0; };
+    }
+};
+
+// Runs one instance from scratch. `index` picks the seed, so the same index replays the same
+// world and population under any Tuning. Seeding: the population and the world draw from
+// separate streams of the instance seed, like main() does with its two Rngs.
+static InstanceStats run_instance(const EntityBrain& brain, const BatchConfig& config, std::size_t index){
+    InstanceStats stats;
+    stats.seed = Rng{config.seed, index}.next();
+    Rng rng{stats.seed};
+    World world;
+    world.rng = Rng{stats.seed, 1};
+    world.tuning = config.tuning;
+    EntityPool population{Blackboard{DemoTree::Keys{}}};
+    population.spawn(config.agents, rng);
+    std::array<std::uint32_t, 4> seconds{}; //agent-frames per Activity
+    std::uint32_t caught = 0;
+    for(int f = 0; f < config.frames; ++f){
+        simulate(world, brain, population, config.dt);
+        for(const auto& e : population.entities()){ ++seconds[static_cast<std::size_t>(e.activity)]; }
+        for(const float d : population.senses().threat.dist){ caught += (d < World::catch_radius) ? 1 : 0; } //as sensed at the start of the frame
+    }
+    const double dt = config.dt;
+    stats.food_eaten = world.food_serial;
+    stats.caught_seconds = caught * dt;
+    stats.flee_seconds = seconds[static_cast<std::size_t>(Activity::Flee)] * dt;
+    stats.seek_food_seconds = seconds[static_cast<std::size_t>(Activity::SeekFood)] * dt;
+    stats.patrol_seconds = seconds[static_cast<std::size_t>(Activity::Patrol)] * dt;
+    stats.agent_seconds = static_cast<double>(config.agents) * config.frames * dt;
+    return stats;
+}
+
+// Runs every instance of the batch on `jobs` and collects their stats (in instance order).
+static BatchStats run_batch(JobSystem& jobs, const EntityBrain& brain, const BatchConfig& config){
+    BatchStats out;
+    out.instances.resize(config.instances);
+    if(config.instances == 0) return out;
+    TaskGraph graph;
+    std::ignore = graph.add("instance", [&](std::size_t i){ out.instances[i] = run_instance(brain, config, i); }, config.instances);
+    jobs.run(graph);
+    out.wall_ns = graph.wall_ns();
+    return out;
+}
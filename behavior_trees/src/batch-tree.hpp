@@ -0,0 +1,174 @@
+#pragma once
+#include "common.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "simulation.hpp"
+
+// BatchTree: ticks a tree for a set of agents node by node, instead of agent by agent.
+//
+// Every node is visited once per frame with the rows of all agents that reach it, and returns a
+// status per row. A Selector passes the rows whose child failed on to its next child, a Sequence
+// the rows whose child succeeded; a MemorySequence groups its rows by the child each agent is at.
+// Leaves with a batch form (Leaf::batch) get the whole row span in one call, so the loop over
+// agents is inside the leaf, where the compiler and SIMD kernels can see it. Other leaves, and
+// nodes BatchTree does not know (coroutine leaves, CachedSubtree, FlatTree), are ticked per row.
+//
+// Each agent sees its leaves in the same order as with EntityBrain::tick. Across agents the order
+// changes, which is fine for leaves that only write their own agent and ctx.commands (as for
+// SimulationGraph; apply_commands does not depend on the order).
+//
+// Row lists live in scratch buffers, one set per tree level, reused from frame to frame.
+
+struct BatchTree final{
+    explicit BatchTree(const Node& root) : root_(&root){
+        levels_.resize(depth(root) + 1);
+    }
+
+    // Leaf calls on the last tick(): in batch form (one per leaf), and per row for the rest.
+    std::size_t batch_calls() const noexcept{ return batch_calls_; }
+    std::size_t scalar_calls() const noexcept{ return scalar_calls_; }
+
+    // Ticks `rows` (ascending) and writes their statuses to `out`.
+    void tick(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float dt) noexcept{
+        assert(out.size() == rows.size());
+        batch_calls_ = scalar_calls_ = 0;
+        visit(*root_, ctx, rows, out, dt, 0);
+    }
+
+    // Ticks every agent of the population once.
+    void tick(World& world, EntityPool& population, WorldCommands* commands, float dt) noexcept{
+        all_.resize(population.size());
+        for(std::size_t i = 0; i < all_.size(); ++i){ all_[i] = static_cast<std::uint32_t>(i); }
+        statuses_.resize(all_.size());
+        BatchContext ctx{world, population.entities(), population.memory(), population.board(), population.senses(), commands};
+        tick(ctx, all_, statuses_, dt);
+    }
+
+private:
+    struct Level final{
+        std::vector<std::uint32_t> rows;  //rows still to be decided
+        std::vector<std::uint32_t> slot;  //their index in the caller's span
+        std::vector<Status> status;       //the child's result for each of them
+    };
+
+    const Node* root_ = nullptr;
+    std::vector<Level> levels_;
+    std::vector<std::uint32_t> all_;
+    std::vector<Status> statuses_;
+    std::size_t batch_calls_ = 0;
+    std::size_t scalar_calls_ = 0;
+
+    static std::size_t depth(const Node& n) noexcept{
+        std::size_t d = 0;
+        for(const Node* c : n.subtrees()){ d = std::max(d, depth(*c) + 1); }
+        return d;
+    }
+
+    void visit(const Node& n, BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float dt, std::size_t level) noexcept{
+        if(rows.empty()) return;
+        switch(n.kind()){
+        case NodeKind::Leaf:{
+            const auto& leaf = static_cast<const Leaf&>(n);
+            if(leaf.batch){
+                leaf.batch(ctx, rows, out, dt);
+                ++batch_calls_;
+                return;
+            }
+            for(std::size_t j = 0; j < rows.size(); ++j){
+                Context c = ctx.at(rows[j]);
+                out[j] = leaf.fn(c, dt);
+            }
+            scalar_calls_ += rows.size();
+            return;
+        }
+        case NodeKind::Sequence: return chain(n.subtrees(), Status::Success, ctx, rows, out, dt, level);
+        case NodeKind::Selector: return chain(n.subtrees(), Status::Failure, ctx, rows, out, dt, level);
+        case NodeKind::MemorySequence: return memory_sequence(static_cast<const MemorySequence&>(n), ctx, rows, out, dt, level);
+        case NodeKind::RepeatForever:{
+            Level& l = levels_[level];
+            l.status.resize(rows.size());
+            visit(*n.subtrees()[0], ctx, rows, l.status, dt, level + 1);
+            std::fill(out.begin(), out.end(), Status::Running);
+            return;
+        }
+        default:
+            for(std::size_t j = 0; j < rows.size(); ++j){
+                Context c = ctx.at(rows[j]);
+                out[j] = n.tick(c, dt);
+            }
+            scalar_calls_ += rows.size();
+            return;
+        }
+    }
+
+    // Sequence (go_on = Success) and Selector (go_on = Failure): rows whose child returned go_on
+    // move on to the next child; the others are decided. Rows past the last child return go_on.
+    void chain(std::span<Node* const> children, Status go_on, BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float dt, std::size_t level) noexcept{
+        Level& l = levels_[level];
+        l.rows.assign(rows.begin(), rows.end());
+        l.slot.resize(rows.size());
+        for(std::size_t j = 0; j < rows.size(); ++j){ l.slot[j] = static_cast<std::uint32_t>(j); }
+        for(const Node* child : children){
+            if(l.rows.empty()) return;
+            l.status.resize(l.rows.size());
+            visit(*child, ctx, l.rows, l.status, dt, level + 1);
+            std::size_t kept = 0;
+            for(std::size_t j = 0; j < l.rows.size(); ++j){
+                if(l.status[j] == go_on){
+                    l.rows[kept] = l.rows[j];
+                    l.slot[kept++] = l.slot[j];
+                } else{
+                    out[l.slot[j]] = l.status[j];
+                }
+            }
+            l.rows.resize(kept);
+            l.slot.resize(kept);
+        }
+        for(const auto j : l.slot){ out[j] = go_on; }
+    }
+
+    // Each agent resumes at its own child (bt_mem[mem_slot]). Children are visited in order with
+    // the rows that are at them, so an agent whose child succeeds joins the next child's rows.
+    void memory_sequence(const MemorySequence& n, BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float dt, std::size_t level) noexcept{
+        Level& l = levels_[level];
+        const auto count = static_cast<int>(n.children.size());
+        for(int c = 0; c < count; ++c){
+            l.rows.clear();
+            l.slot.clear();
+            for(std::size_t j = 0; j < rows.size(); ++j){
+                if(ctx.memory[rows[j]].bt_mem[n.mem_slot] == c){
+                    l.rows.push_back(rows[j]);
+                    l.slot.push_back(static_cast<std::uint32_t>(j));
+                }
+            }
+            if(l.rows.empty()) continue;
+            l.status.resize(l.rows.size());
+            visit(*n.children[c], ctx, l.rows, l.status, dt, level + 1);
+            for(std::size_t j = 0; j < l.rows.size(); ++j){
+                int& at = ctx.memory[l.rows[j]].bt_mem[n.mem_slot];
+                const Status s = l.status[j];
+                if(s == Status::Running){
+                    out[l.slot[j]] = Status::Running;
+                } else if(s == Status::Failure){
+                    at = 0;
+                    out[l.slot[j]] = Status::Failure;
+                } else if(++at == count){
+                    at = 0;
+                    out[l.slot[j]] = Status::Success;
+                }
+            }
+        }
+    }
+};
+
+// simulate() with the tree ticked by a BatchTree: the same step and the same result.
+static void simulate(World& world, BatchTree& tree, EntityPool& population, float dt) noexcept{
+    const bool flocking = prepare_step(world, population, dt);
+    tree.tick(world, population, &world.commands, dt);
+    auto entities = population.entities();
+    for(std::size_t i = 0; i < entities.size(); ++i){
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    apply_commands(world, population, {&world.commands, 1});
+}
@@ -2,18 +2,65 @@
 #include "common.hpp"
 #include "entity.hpp"
 #include "world.hpp"
+#include "blackboard.hpp"
+#include "perception.hpp"
 
 enum class Status{ Success, Failure, Running };
 
+// What a leaf reads, for CachedSubtree (subtree-cache.hpp). Bits 0-31 are blackboard keys by id,
+// then one bit per WorldInput, then the entity's own motion state, which Entity::update
+// rewrites every frame (so anything reading it is never cached).
+using Inputs = std::uint64_t;
+static_assert(Blackboard::max_keys <= 32);
+template <typename K>
+constexpr Inputs reads_key = Inputs{1} << K::id;
+constexpr Inputs reads_world(WorldInput w) noexcept{ return Inputs{1} << (32 + static_cast<unsigned>(w)); }
+constexpr Inputs reads_self = Inputs{1} << 48;  //position, velocity, and the senses derived from them
+constexpr Inputs reads_anything = ~Inputs{0};
+
+// Bitmask of the statuses a node can return, for the tree optimizer.
+constexpr std::uint8_t outcome(Status s) noexcept{ return static_cast<std::uint8_t>(1u << static_cast<unsigned>(s)); }
+constexpr std::uint8_t any_outcome = outcome(Status::Success) | outcome(Status::Failure) | outcome(Status::Running);
+
 struct Context final{
-    Entity& self;
+    Entity& self;           //hot record
+    EntityMemory& memory;   //cold side table: per-node BT memory
     World& world;
+    Blackboard& board;      //typed per-entity leaf state, see blackboard.hpp
+    const Senses& senses;   //this frame's perception, see perception.hpp
+    std::size_t index;      //this entity's row in the blackboard and the senses
+    WorldCommands* commands = nullptr; //deferred world writes; required by leaves that write the world (DoSeekFood)
+
+    template <typename K>
+    const typename K::type& get() const noexcept{ return board.get<K>(index); }
+
+    // Tracked write: caches reading K are invalidated (when the value changes).
+    template <typename K>
+    void set(const typename K::type& value) noexcept{ board.set<K>(index, value, world.frame); }
 };
 
+// What a batch leaf sees: the whole population as views, plus the rows it is ticked for.
+struct BatchContext final{
+    World& world;
+    std::span<Entity> entities;
+    std::span<EntityMemory> memory;
+    Blackboard& board;
+    const Senses& senses;
+    WorldCommands* commands = nullptr;
+
+    Context at(std::size_t row) const noexcept{ return {entities[row], memory[row], world, board, senses, row, commands}; }
+};
+
+// Lets tools (see tree-optimizer.hpp) walk a tree without knowing the concrete types.
+// Nodes that do not override kind() are treated as opaque leaves.
+enum class NodeKind : std::uint8_t{ Leaf, Sequence, Selector, MemorySequence, RepeatForever, Opaque };
+
 // Base node interface
 struct Node{
     virtual ~Node() = default;
     virtual Status tick(Context& ctx, float dt) const noexcept = 0;
+    virtual NodeKind kind() const noexcept{ return NodeKind::Opaque; }
+    virtual std::span<Node* const> subtrees() const noexcept{ return {}; }
 };
 
 // Composite: Sequence
@@ -23,6 +70,9 @@ struct Node{
 struct Sequence final : Node{
     std::vector<Node*> children;
     explicit Sequence(std::initializer_list<Node*> xs) : children(xs){}
+    explicit Sequence(std::vector<Node*> xs) : children(std::move(xs)){}
+    NodeKind kind() const noexcept override{ return NodeKind::Sequence; }
+    std::span<Node* const> subtrees() const noexcept override{ return children; }
 
     Status tick(Context& ctx, float dt) const noexcept override{
         for(const auto* child : children){
@@ -41,6 +91,9 @@ struct Sequence final : Node{
 struct Selector final : Node{
     std::vector<Node*> children;
     explicit Selector(std::initializer_list<Node*> xs) : children(xs){}
+    explicit Selector(std::vector<Node*> xs) : children(std::move(xs)){}
+    NodeKind kind() const noexcept override{ return NodeKind::Selector; }
+    std::span<Node* const> subtrees() const noexcept override{ return children; }
 
     Status tick(Context& ctx, float dt) const noexcept override{        
         for(const auto* child : children){
@@ -60,10 +113,14 @@ struct MemorySequence final : Node{
 
     MemorySequence(int slot, std::initializer_list<Node*> xs)
         : children(xs), mem_slot(slot){}
+    MemorySequence(int slot, std::vector<Node*> xs)
+        : children(std::move(xs)), mem_slot(slot){}
+    NodeKind kind() const noexcept override{ return NodeKind::MemorySequence; }
+    std::span<Node* const> subtrees() const noexcept override{ return children; }
 
     Status tick(Context& ctx, float dt) const noexcept override{
-        assert(mem_slot < ctx.self.bt_mem.size());
-        int& i = ctx.self.bt_mem[mem_slot]; //grab a reference to the entity's memory of this behavior
+        assert(mem_slot < ctx.memory.bt_mem.size());
+        int& i = ctx.memory.bt_mem[mem_slot]; //grab a reference to the entity's memory of this behavior
         while(i < (int) children.size()){
             const Status s = children[i]->tick(ctx, dt);
             if(s == Status::Running){
@@ -83,6 +140,8 @@ struct MemorySequence final : Node{
 struct RepeatForever final : Node{
     Node* child{};
     explicit RepeatForever(Node* c) : child(c){}
+    NodeKind kind() const noexcept override{ return NodeKind::RepeatForever; }
+    std::span<Node* const> subtrees() const noexcept override{ return {&child, 1}; }
 
     Status tick(Context& ctx, float dt) const noexcept override{
         std::ignore = child->tick(ctx, dt);
@@ -95,9 +154,38 @@ struct RepeatForever final : Node{
 // to enforce that leaf nodes are stateless; all behavior state lives in Context
 using LeafFn = Status(*)(Context&, float) noexcept;
 
+// What the tree optimizer may assume about a leaf. The defaults assume nothing.
+struct LeafTraits final{
+    const char* name = "leaf";
+    std::uint8_t outcomes = any_outcome; //statuses the leaf can return
+    bool commutative = false;            //pure condition: no side effects, never Running, may be reordered among its siblings
+    Inputs reads = reads_anything;       //what the result depends on
+    Inputs writes = reads_anything;      //what it may change: reads_key bits of its own agent's row, or anything
+};
+
+constexpr LeafTraits condition(const char* name, Inputs reads = reads_anything) noexcept{
+    return {name, static_cast<std::uint8_t>(outcome(Status::Success) | outcome(Status::Failure)), true, reads, 0};
+}
+// A condition that also writes blackboard keys of its own agent, e.g. a note for later frames
+// (ThreatNearby's ThreatSafeUntil). Never Running, but not pure: it is neither reordered nor cached.
+constexpr LeafTraits condition_writing(const char* name, Inputs reads, Inputs writes) noexcept{
+    return {name, static_cast<std::uint8_t>(outcome(Status::Success) | outcome(Status::Failure)), false, reads, writes};
+}
+constexpr LeafTraits action(const char* name, std::uint8_t outcomes = any_outcome) noexcept{
+    return {name, outcomes, false, reads_anything, reads_anything};
+}
+
+// Optional batch form of a leaf, used by BatchTree (batch-tree.hpp): ticks the leaf for every
+// agent in `rows` (ascending) and writes out[j] for rows[j]. It must leave every agent exactly as
+// the scalar form would, so the two can be mixed freely; leaves without one are called per row.
+using BatchLeafFn = void(*)(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float dt) noexcept;
+
 struct Leaf final : Node{
     LeafFn fn{};
-    explicit Leaf(LeafFn f) : fn(f){}
+    LeafTraits traits{};
+    BatchLeafFn batch{};
+    explicit Leaf(LeafFn f, LeafTraits t = {}, BatchLeafFn b = nullptr) : fn(f), traits(t), batch(b){}
+    NodeKind kind() const noexcept override{ return NodeKind::Leaf; }
     Status tick(Context& ctx, float dt) const noexcept override{ return fn(ctx, dt); }
 };
 
@@ -0,0 +1,196 @@
+#pragma once
+#include "common.hpp"
+#include "frame-arena.hpp"
+#include <cstring>
+#include <type_traits>
+
+// Typed, per-entity blackboard.
+//
+// Keys are types with a compile-time id and a value type:
+//
+//   struct WaypointIndex final : BlackboardKey<int, 0>{
+//       static int initial(Rng& rng) noexcept{ return rng.range(0, 3); } //optional, defaults to int{}
+//   };
+//
+// A tree lists the keys its leaves read or write (using Keys = KeySet<WaypointIndex, ...>),
+// and the population's Blackboard allocates one column (structure-of-arrays) per listed key
+// and nothing for the rest. Access is an array index by key id plus a row index: no hashing,
+// no lookup. Rows line up with the entity pool's dense index and move with it.
+//
+// Values must be trivially copyable; columns are moved around as raw bytes.
+//
+// set() also stamps the row with the frame of the write (only when the value actually changes),
+// which is what lets CachedSubtree (subtree-cache.hpp) notice that an input changed.
+// Writes through the mutable get() or column() are not tracked.
+
+template <typename T, std::size_t Id>
+struct BlackboardKey{
+    static_assert(std::is_trivially_copyable_v<T>, "blackboard values are moved as raw bytes");
+    using type = T;
+    static constexpr std::size_t id = Id;
+    static T initial(Rng&) noexcept{ return T{}; }
+};
+
+template <typename... Keys>
+struct KeySet final{};
+
+// A tree's keys plus those something running it needs on top, e.g. KeySetWith<DemoTree::Keys, ActiveBranch>.
+template <typename Set, typename... More>
+struct KeySetConcat;
+template <typename... Keys, typename... More>
+struct KeySetConcat<KeySet<Keys...>, More...> final{ using type = KeySet<Keys..., More...>; };
+template <typename Set, typename... More>
+using KeySetWith = typename KeySetConcat<Set, More...>::type;
+
+struct Blackboard final{
+    static constexpr std::size_t max_keys = 32;
+
+    Blackboard() noexcept = default;
+
+    template <typename... Keys>
+    explicit Blackboard(KeySet<Keys...>){
+        (add_column<Keys>(), ...);
+    }
+
+    template <typename K>
+    bool has() const noexcept{
+        return columns_[K::id].stride != 0;
+    }
+
+    template <typename K>
+    typename K::type& get(std::size_t row) noexcept{
+        assert(has<K>() && "key is not part of this tree's KeySet");
+        assert(row < rows_);
+        return reinterpret_cast<typename K::type*>(columns_[K::id].data.data())[row];
+    }
+
+    template <typename K>
+    const typename K::type& get(std::size_t row) const noexcept{
+        assert(has<K>() && "key is not part of this tree's KeySet");
+        assert(row < rows_);
+        return reinterpret_cast<const typename K::type*>(columns_[K::id].data.data())[row];
+    }
+
+    template <typename K>
+    void set(std::size_t row, const typename K::type& value, std::uint32_t frame) noexcept{
+        auto& current = get<K>(row);
+        if(std::memcmp(&current, &value, sizeof(value)) == 0) return;
+        current = value;
+        columns_[K::id].written[row] = frame;
+    }
+
+    // Frame of the last set() of key `id` on `row`; 0 if never.
+    std::uint32_t written(std::size_t id, std::size_t row) const noexcept{
+        assert(id < max_keys && columns_[id].stride != 0 && row < rows_);
+        return columns_[id].written[row];
+    }
+
+    // The whole column, for batch kernels.
+    template <typename K>
+    std::span<typename K::type> column() noexcept{
+        assert(has<K>());
+        return {reinterpret_cast<typename K::type*>(columns_[K::id].data.data()), rows_};
+    }
+
+    std::size_t size() const noexcept{ return rows_; }
+
+    std::size_t bytes_per_row() const noexcept{
+        std::size_t bytes = 0;
+        for(const auto& c : columns_){ bytes += c.stride; }
+        return bytes;
+    }
+
+    // Room for `rows` rows, so appending up to that many does not reallocate.
+    void reserve(std::size_t rows){
+        for(auto& c : columns_){
+            if(c.stride == 0) continue;
+            c.data.reserve(rows * c.stride);
+            c.written.reserve(rows);
+        }
+    }
+
+    // Appends `count` rows, initialized with each key's initial(rng), or value-initialized without an rng.
+    void append(std::size_t count, Rng* rng){
+        for(auto& c : columns_){
+            if(c.stride == 0) continue;
+            c.data.resize((rows_ + count) * c.stride);
+            c.written.resize(rows_ + count, 0);
+            std::byte* row = c.data.data() + rows_ * c.stride;
+            for(std::size_t i = 0; i < count; ++i, row += c.stride){
+                if(rng){ c.init(row, *rng); } else{ std::memset(row, 0, c.stride); }
+            }
+        }
+        rows_ += count;
+    }
+
+    // Moves row `from` into row `to` and drops the last row (the pool's swap-remove).
+    void swap_remove(std::size_t to, std::size_t from) noexcept{
+        assert(from == rows_ - 1 && to < rows_);
+        for(auto& c : columns_){
+            if(c.stride == 0) continue;
+            if(to != from){
+                std::memcpy(c.data.data() + to * c.stride, c.data.data() + from * c.stride, c.stride);
+                c.written[to] = c.written[from];
+            }
+            c.data.resize(from * c.stride);
+            c.written.resize(from);
+        }
+        --rows_;
+    }
+
+    // Row i takes the value (and write stamp) of row order[i]; `order` is a permutation of every row.
+    // Each column is gathered into frame memory and copied back, so the columns keep their buffers
+    // (swapping buffers of different sizes would reallocate on every call).
+    void permute(std::span<const std::uint32_t> order){
+        assert(order.size() == rows_);
+        FrameArena& arena = frame_arena();
+        for(auto& c : columns_){
+            if(c.stride == 0) continue;
+            const std::size_t bytes = c.data.size();
+            auto* data = static_cast<std::byte*>(arena.allocate(bytes, alignof(std::max_align_t)));
+            auto* written = static_cast<std::uint32_t*>(arena.allocate(rows_ * sizeof(std::uint32_t), alignof(std::uint32_t)));
+            c.gather(data, c.data.data(), order);
+            for(std::size_t i = 0; i < rows_; ++i){ written[i] = c.written[order[i]]; }
+            std::memcpy(c.data.data(), data, bytes);
+            std::memcpy(c.written.data(), written, rows_ * sizeof(std::uint32_t));
+            arena.deallocate(written, rows_ * sizeof(std::uint32_t)); //last in, first out: the next column reuses the space
+            arena.deallocate(data, bytes);
+        }
+    }
+
+    void clear() noexcept{
+        for(auto& c : columns_){
+            c.data.clear();
+            c.written.clear();
+        }
+        rows_ = 0;
+    }
+
+private:
+    struct Column final{
+        std::vector<std::byte> data;
+        std::vector<std::uint32_t> written; //per row: frame of the last set()
+        std::size_t stride = 0;  //0 = key not used by this tree
+        void(*init)(std::byte*, Rng&) noexcept = nullptr;
+        void(*gather)(std::byte* dst, const std::byte* src, std::span<const std::uint32_t> order) noexcept = nullptr; //dst row i = src row order[i]
+    };
+
+    std::array<Column, max_keys> columns_{};
+    std::size_t rows_ = 0;
+
+    template <typename K>
+    void add_column() noexcept{
+        static_assert(K::id < max_keys, "raise Blackboard::max_keys");
+        using T = typename K::type;
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        assert(columns_[K::id].stride == 0 && "two keys share an id");
+        columns_[K::id].stride = sizeof(T);
+        columns_[K::id].init = [](std::byte* dst, Rng& rng) noexcept{
+            const T value = K::initial(rng);
+            std::memcpy(dst, &value, sizeof(T));
+        };
+        columns_[K::id].gather = [](std::byte* dst, const std::byte* src, std::span<const std::uint32_t> order) noexcept{
+            for(std::size_t i = 0; i < order.size(); ++i){ std::memcpy(dst + i * sizeof(T), src + order[i] * sizeof(T), sizeof(T)); }
+        };
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include "common.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "simulation.hpp"
+
+// BucketedBrain: ticks the population grouped by the branch of the root Selector each agent was
+// in last frame, instead of in row order.
+//
+// In row order, neighbouring agents flee, seek food and patrol in no particular pattern, so every
+// guard in the root Selector and every virtual call behind it sees a coin flip. Grouped, the
+// agents of a bucket mostly take the same path as the agent before them: the higher-priority
+// guards fail, their own branch runs.
+//
+// The branch is the ActiveBranch blackboard key, rewritten only when it changes, so it moves with
+// the agent through despawns and re-sorts. The buckets themselves are a counting pass over that
+// column at the start of each tick, which keeps each bucket in row order.
+//
+// Each agent is still ticked from the first child: the higher-priority branches must be checked
+// again. Children that are a Sequence starting with a leaf that never returns Running (a
+// condition, pure or not) are split into that guard, called directly, and the rest of the
+// sequence, which only runs when the guard passes. The guard is called exactly when the Sequence
+// would call it, so the statuses and side effects are exactly those of the Selector.
+//
+// Leaves must only write their own agent, its blackboard row and ctx.commands, as for
+// SimulationGraph; the commands are order-independent (see apply_commands).
+struct BucketedBrain final{
+    static constexpr std::size_t max_branches = 15; //ActiveBranch holds the index, or the count if all failed
+    // The tree's keys plus the ActiveBranch column, e.g. Blackboard{BucketedBrain::Keys<DemoTree::Keys>{}}.
+    template <typename TreeKeys>
+    using Keys = KeySetWith<TreeKeys, ActiveBranch>;
+
+    explicit BucketedBrain(const Node& root){
+        assert(root.kind() == NodeKind::Selector && "BucketedBrain buckets by the root Selector's children");
+        const auto children = root.subtrees();
+        assert(children.size() <= max_branches);
+        for(const Node* child : children){
+            Branch b{child};
+            const auto kids = child->subtrees();
+            if(child->kind() == NodeKind::Sequence && !kids.empty() && kids[0]->kind() == NodeKind::Leaf){
+                const auto& first = static_cast<const Leaf&>(*kids[0]);
+                if((first.traits.outcomes & outcome(Status::Running)) == 0){
+                    b.guard = first.fn;
+                    b.rest = kids.subspan(1);
+                }
+            }
+            branches_.push_back(b);
+        }
+    }
+
+    std::size_t branch_count() const noexcept{ return branches_.size(); }
+
+    // Agents per bucket and how many agents changed bucket, on the last tick().
+    std::span<const std::uint32_t> bucket_sizes() const noexcept{ return {sizes_.data(), branches_.size() + 1}; }
+    std::size_t last_changes() const noexcept{ return changes_; }
+
+    // Ticks every agent once, bucket by bucket. Does not integrate.
+    void tick(World& world, EntityPool& population, WorldCommands* commands, float dt) noexcept{
+        auto& board = population.board();
+        assert(board.has<ActiveBranch>() && "make the Blackboard from BucketedBrain::Keys<the tree's Keys>");
+        const auto branch = board.column<ActiveBranch>();
+        const std::size_t buckets = branches_.size() + 1;
+        sizes_.fill(0);
+        for(const auto b : branch){ ++sizes_[std::min<std::size_t>(b, buckets - 1)]; }
+        std::array<std::uint32_t, max_branches + 1> cursor{};
+        for(std::size_t b = 1; b < buckets; ++b){ cursor[b] = cursor[b - 1] + sizes_[b - 1]; }
+        rows_.resize(branch.size());
+        for(std::size_t i = 0; i < branch.size(); ++i){ rows_[cursor[std::min<std::size_t>(branch[i], buckets - 1)]++] = static_cast<std::uint32_t>(i); }
+
+        auto entities = population.entities();
+        auto memory = population.memory();
+        const auto& senses = population.senses();
+        changes_ = 0;
+        for(const auto i : rows_){
+            Context ctx{entities[i], memory[i], world, board, senses, i, commands};
+            std::uint8_t active = 0;
+            std::ignore = tick_agent(ctx, dt, active);
+            if(active != branch[i]){
+                branch[i] = active;
+                ++changes_;
+            }
+        }
+    }
+
+private:
+    struct Branch final{
+        const Node* node = nullptr;
+        LeafFn guard = nullptr;         //the Sequence's leading condition, if it has one
+        std::span<Node* const> rest{};  //the Sequence's other children
+    };
+
+    std::vector<Branch> branches_;
+    std::vector<std::uint32_t> rows_;   //this tick's order: rows by bucket
+    std::array<std::uint32_t, max_branches + 1> sizes_{};
+    std::size_t changes_ = 0;
+
+    // The root Selector's tick, with guarded Sequences split open.
+    Status tick_agent(Context& ctx, float dt, std::uint8_t& active) const noexcept{
+        for(std::size_t k = 0; k < branches_.size(); ++k){
+            const Branch& b = branches_[k];
+            Status s = Status::Success;
+            if(b.guard){
+                if(b.guard(ctx, dt) == Status::Failure) continue;
+                for(const Node* child : b.rest){
+                    s = child->tick(ctx, dt);
+                    if(s != Status::Success) break;
+                }
+            } else{
+                s = b.node->tick(ctx, dt);
+            }
+            if(s != Status::Failure){
+                active = static_cast<std::uint8_t>(k);
+                return s;
+            }
+        }
+        active = static_cast<std::uint8_t>(branches_.size());
+        return Status::Failure;
+    }
+};
+
+// simulate() with the tick done by a BucketedBrain: the same step and the same result, but the
+// agents are ticked bucket by bucket and integrated afterwards in row order.
+static void simulate(World& world, BucketedBrain& brain, EntityPool& population, float dt) noexcept{
+    const bool flocking = prepare_step(world, population, dt);
+    brain.tick(world, population, &world.commands, dt);
+    auto entities = population.entities();
+    for(std::size_t i = 0; i < entities.size(); ++i){
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    apply_commands(world, population, {&world.commands, 1});
+}
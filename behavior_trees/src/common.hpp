@@ -17,6 +17,7 @@
 #include <initializer_list>
 #include <tuple>
 #include <limits>
+#include <cstdint>
 
 // --- Constants ---
 constexpr int STAGE_WIDTH = 1280;
@@ -56,6 +57,46 @@ static Vector2 vector_from_angle(float angle, float magnitude) noexcept{
     return {std::cos(angle) * magnitude, std::sin(angle) * magnitude};
 }
 
+// Small PCG32 generator for bulk work (spawning thousands of agents, batch simulations).
+// Seed it once, e.g. from GetRandomValue, instead of calling into raylib for every value.
+struct Rng final{
+    std::uint64_t state = 0x853c49e6748fea9bULL;
+    std::uint64_t inc = 0xda3e39cb94b95bdbULL;
+
+    Rng() noexcept = default;
+    explicit Rng(std::uint64_t seed, std::uint64_t stream = 54u) noexcept : state(0), inc((stream << 1u) | 1u){
+        std::ignore = next();
+        state += seed;
+        std::ignore = next();
+    }
+
+    std::uint32_t next() noexcept{
+        const std::uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        const auto xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+        const auto rot = static_cast<std::uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    float range01() noexcept{ // [0, 1)
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float min, float max) noexcept{
+        assert(min < max);
+        return min + ((max - min) * range01());
+    }
+
+    Vector2 range(Vector2 min, Vector2 max) noexcept{
+        return {range(min.x, max.x), range(min.y, max.y)};
+    }
+
+    int range(int min, int max) noexcept{ // inclusive, like GetRandomValue
+        assert(min <= max);
+        return min + static_cast<int>(next() % static_cast<std::uint32_t>(max - min + 1));
+    }
+};
+
 template <typename T>
 static void shuffle(std::span<T> range) noexcept{
     if(range.size() < 2) return;
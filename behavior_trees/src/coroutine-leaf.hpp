@@ -0,0 +1,213 @@
+#pragma once
+#include "behavior-tree.hpp"
+#include <coroutine>
+#include <memory>
+#include <new>
+
+// Coroutine leaves: long-running actions written as straight-line code.
+//
+//   static Action Patrol(Tick& t){
+//       for(;;){
+//           ...steer using t.context()...
+//           co_await t.next_tick();   //suspend: the leaf returns Running this frame
+//       }
+//   }
+//
+// The coroutine frame lives in a fixed-size slot of a CoroutineArena, never on the heap,
+// and the slot is remembered in the entity's bt_mem, with the frame the entity last ticked
+// it. Each slot keeps its bookkeeping right in
+// front of the frame, so a resume touches one place in memory and makes one indirect call.
+//
+// Rules for action authors:
+// * Never keep a Context& (or Entity&) across a co_await. The Context is rebuilt every frame
+//   and the pool may move entities; read t.context() again after every resume.
+// * co_return Status::Success / Status::Failure to finish. Running is what co_await means.
+// * Locals are destroyed when the action is preempted, so RAII cleanup works as usual.
+//
+// Preemption: the composites are reactive and never tell a child that it lost control.
+// A CoroutineLeaf instead notices that it was not ticked on the previous frame and restarts,
+// and CoroutineArena::reap() (call once per frame) destroys frames nobody resumed, so a
+// preempted or despawned agent gives its slot back within one frame. The slot may then go to
+// another agent; the preempted one knows its code is stale from its own frame stamp and never
+// looks the slot up again.
+
+struct Tick final{
+    Context* ctx = nullptr;
+    float dt = 0.0f;
+    std::byte* storage = nullptr;    //frame memory of the arena slot this action runs in
+    std::size_t capacity = 0;
+
+    Context& context() const noexcept{
+        assert(ctx);
+        return *ctx;
+    }
+
+    static constexpr std::suspend_always next_tick() noexcept{ return {}; }
+};
+
+struct Action final{
+    struct promise_type final{
+        Status result = Status::Running;
+
+        // Frames are placed in the Tick's arena slot. Failing here (frame too large for
+        // the slot) makes the coroutine call return an empty Action instead of throwing.
+        static void* operator new(std::size_t size, Tick& t) noexcept{
+            return (size <= t.capacity) ? t.storage : nullptr;
+        }
+        static void operator delete(void*) noexcept{} //the arena owns the memory
+        static Action get_return_object_on_allocation_failure() noexcept{ return Action{}; }
+
+        Action get_return_object() noexcept{
+            return Action{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept{ return {}; }
+        std::suspend_always final_suspend() noexcept{ return {}; }
+        void return_value(Status s) noexcept{ result = s; }
+        void unhandled_exception() noexcept{ std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle{};
+};
+
+using ActionFn = Action(*)(Tick&);
+
+// Fixed pool of coroutine frames. All memory is allocated once, up front.
+struct CoroutineArena final{
+    CoroutineArena(std::size_t capacity, std::size_t frame_bytes = 256)
+        : frame_bytes_(frame_bytes), stride_((header + frame_bytes + sizeof(Line) - 1) / sizeof(Line) * sizeof(Line)), capacity_(capacity),
+          storage_(std::make_unique<Line[]>(capacity * stride_ / sizeof(Line))){
+        assert(capacity < static_cast<std::size_t>(std::numeric_limits<int>::max()));
+        assert(frame_bytes % alignof(std::max_align_t) == 0); //keeps every slot suitably aligned
+        for(std::size_t i = 0; i < capacity; ++i){
+            Slot* s = new(base() + i * stride_) Slot{};
+            s->next_free = (i + 1 < capacity) ? static_cast<std::uint32_t>(i + 1) : none;
+        }
+        free_ = (capacity > 0) ? 0 : none;
+    }
+    CoroutineArena(const CoroutineArena&) = delete;
+    CoroutineArena& operator=(const CoroutineArena&) = delete;
+    ~CoroutineArena(){
+        for(std::uint32_t i = 0; i < capacity_; ++i){
+            if(slot(i).handle) slot(i).handle.destroy();
+        }
+    }
+
+    // Runs one tick of the action remembered in `code` (an entity's bt_mem entry), which the
+    // entity last ticked on frame `ticked` (its next entry): restarts it if it was preempted,
+    // starts it if there is none, then resumes it. Finished actions give their slot back and
+    // reset `code` to 0.
+    Status tick(int& code, std::uint32_t& ticked, ActionFn fn, Context& ctx, float dt) noexcept{
+        const std::uint32_t frame = ctx.world.frame;
+        if(ticked + 1 < frame){ code = 0; } //not ticked last frame: it lost control, and reap() took the slot back
+        ticked = frame;
+        Slot* s = lookup(code);
+        assert((code == 0 || s) && "CoroutineArena: a running action was released; call reap() once per frame, after the tick");
+        if(!s){
+            code = start(fn);
+            if(code == 0){ //arena exhausted, or the frame does not fit a slot: not a gameplay failure
+                ++failed_starts_;
+                assert(false && "CoroutineArena: no slot for the action; raise capacity or frame_bytes");
+                return Status::Failure;
+            }
+            s = &slot(static_cast<std::uint32_t>(code - 1));
+        }
+        s->tick.ctx = &ctx;
+        s->tick.dt = dt;
+        s->last_frame = frame;
+        s->handle.resume();
+        if(!s->handle.done()) return Status::Running;
+        const Status result = s->handle.promise().result;
+        release(code);
+        code = 0;
+        return result;
+    }
+
+    void release(int code) noexcept{
+        Slot* s = lookup(code);
+        if(!s) return;
+        s->handle.destroy(); //runs the destructors of the action's locals
+        s->handle = {};
+        s->next_free = free_;
+        free_ = static_cast<std::uint32_t>(code - 1);
+        --in_use_;
+    }
+
+    // Destroys every action that was not resumed during `frame`. Call once per frame, after the tick.
+    void reap(std::uint32_t frame) noexcept{
+        for(std::uint32_t i = 0; i < capacity_; ++i){
+            const Slot& s = slot(i);
+            if(s.handle && s.last_frame != frame){
+                release(static_cast<int>(i + 1));
+            }
+        }
+    }
+
+    std::size_t in_use() const noexcept{ return in_use_; }
+    std::size_t capacity() const noexcept{ return capacity_; }
+    std::size_t frame_bytes() const noexcept{ return frame_bytes_; }
+    // Actions that could not start because no slot was free or their frame was too large. The leaf
+    // fails them, which the tree cannot tell from the action failing, so this should stay 0.
+    std::size_t failed_starts() const noexcept{ return failed_starts_; }
+
+private:
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    struct Slot final{
+        std::coroutine_handle<Action::promise_type> handle{};
+        Tick tick{};
+        std::uint32_t last_frame = 0;
+        std::uint32_t next_free = none;
+    };
+    struct alignas(64) Line final{ std::byte bytes[64]; }; //a cache line
+    //each slot starts a cache line: a Slot, padded to keep the frame after it aligned, then the frame
+    static constexpr std::size_t header = (sizeof(Slot) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    std::size_t frame_bytes_ = 0;
+    std::size_t stride_ = 0;
+    std::size_t capacity_ = 0;
+    std::unique_ptr<Line[]> storage_;
+    std::uint32_t free_ = none;
+    std::size_t in_use_ = 0;
+    std::size_t failed_starts_ = 0;
+
+    Slot& slot(std::uint32_t index) const noexcept{
+        return *std::launder(reinterpret_cast<Slot*>(base() + index * stride_));
+    }
+    std::byte* base() const noexcept{ return reinterpret_cast<std::byte*>(storage_.get()); }
+
+    int start(ActionFn fn) noexcept{
+        if(free_ == none) return 0;
+        const std::uint32_t index = free_;
+        Slot& s = slot(index);
+        s.tick = Tick{nullptr, 0.0f, base() + index * stride_ + header, frame_bytes_};
+        s.handle = fn(s.tick).handle;
+        if(!s.handle) return 0;
+        free_ = s.next_free;
+        ++in_use_;
+        return static_cast<int>(index + 1);
+    }
+
+    //bt_mem holds index + 1; 0 means "no action running"
+    Slot* lookup(int code) noexcept{
+        if(code <= 0 || static_cast<std::size_t>(code) > capacity_) return nullptr;
+        Slot& s = slot(static_cast<std::uint32_t>(code - 1));
+        return s.handle ? &s : nullptr;
+    }
+};
+
+// Leaf node running an Action coroutine, one instance per entity.
+// Uses bt_mem[mem_slot] to remember which arena slot holds this entity's frame, and
+// bt_mem[mem_slot + 1] for the frame it last ticked it.
+struct CoroutineLeaf final : Node{
+    ActionFn fn{};
+    int mem_slot = 0;
+    CoroutineArena* arena = nullptr;
+
+    CoroutineLeaf(int slot, ActionFn f, CoroutineArena& a) : fn(f), mem_slot(slot), arena(&a){}
+
+    Status tick(Context& ctx, float dt) const noexcept override{
+        assert(static_cast<std::size_t>(mem_slot) + 1 < ctx.memory.bt_mem.size());
+        auto& ticked = reinterpret_cast<std::uint32_t&>(ctx.memory.bt_mem[mem_slot + 1]);
+        return arena->tick(ctx.memory.bt_mem[mem_slot], ticked, fn, ctx, dt);
+    }
+};
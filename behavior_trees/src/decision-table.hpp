@@ -0,0 +1,180 @@
+#pragma once
+#include "common.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "simulation.hpp"
+
+// DecisionTable: the root Selector's decision, compiled out of the tree.
+//
+// The branches of DemoTree's root are Sequences gated by conditions (ThreatNearby, CheckHunger),
+// then a fallback. The table takes every leading pure condition of every branch as a guard,
+// evaluates each guard for the whole population at once into a bitmask, and looks the branch up
+// from the agent's guard bits:
+//
+//   pattern = bit k set if guard k holds       (one bit per guard, at most max_guards)
+//   next[k][pattern] = first branch >= k whose guards all hold, or which has none
+//
+// Per agent, only the chosen branch's other children run (the actions); a branch that fails
+// moves on to next[k + 1][pattern], exactly as the Selector would.
+//
+// Guards with a BatchCondition kernel are computed by it; the others are ticked once per agent.
+// Pure conditions have no side effects (LeafTraits::commutative), so evaluating a guard for an
+// agent the Selector would not have asked changes nothing. A condition that writes its own
+// agent's keys (condition_writing) is a guard only as the very first child of the first branch:
+// the Selector asks it of every agent before anything else, just like the table does (ThreatNearby
+// and its ThreatSafeUntil). All guards are evaluated before any action runs, which is equivalent
+// as long as leaves only write their own agent (see SimulationGraph) and a branch that fails
+// leaves alone what later guards read.
+
+// A pure condition for the whole population: bit i of `out` is the leaf's result for row i.
+using BatchConditionFn = void(*)(World& world, EntityPool& population, std::span<std::uint64_t> out) noexcept;
+
+struct BatchCondition final{
+    LeafFn leaf = nullptr;
+    BatchConditionFn batch = nullptr;
+};
+
+struct DecisionTable final{
+    static constexpr std::size_t max_guards = 8;
+
+    DecisionTable(const Node& root, std::span<const BatchCondition> kernels){
+        assert(root.kind() == NodeKind::Selector && "DecisionTable compiles the root Selector");
+        for(const Node* child : root.subtrees()){
+            Branch b{child};
+            if(child->kind() == NodeKind::Sequence){
+                const auto kids = child->subtrees();
+                std::size_t lead = 0;
+                for(; lead < kids.size() && is_guard(*kids[lead], branches_.empty() && lead == 0); ++lead){
+                    b.guards |= 1u << guard_of(static_cast<const Leaf&>(*kids[lead]).fn, kernels);
+                }
+                b.rest = kids.subspan(lead);
+            }
+            branches_.push_back(b);
+        }
+        const std::size_t patterns = std::size_t{1} << guards_.size();
+        next_.assign((branches_.size() + 1) * patterns, static_cast<std::uint8_t>(branches_.size()));
+        for(std::size_t k = branches_.size(); k-- > 0;){
+            for(std::size_t p = 0; p < patterns; ++p){
+                const bool open = (p & branches_[k].guards) == branches_[k].guards;
+                next_[k * patterns + p] = open ? static_cast<std::uint8_t>(k) : next_[(k + 1) * patterns + p];
+            }
+        }
+        counts_.assign(branches_.size() + 1, 0);
+    }
+
+    std::size_t guard_count() const noexcept{ return guards_.size(); }
+    std::size_t batched_guards() const noexcept{
+        return static_cast<std::size_t>(std::count_if(guards_.begin(), guards_.end(), [](const Guard& g){ return g.batch != nullptr; }));
+    }
+    std::size_t table_bytes() const noexcept{ return next_.size(); }
+    // Agents whose tick ended in each branch (the last entry: none) since evaluate().
+    std::span<const std::uint32_t> branch_counts() const noexcept{ return counts_; }
+
+    // Fills every guard's bitmask. Call once per frame, after perception and before tick().
+    void evaluate(World& world, EntityPool& population) noexcept{
+        const std::size_t words = (population.size() + 63) / 64;
+        for(auto& g : guards_){
+            g.bits.resize(words);
+            if(g.batch){
+                g.batch(world, population, g.bits);
+                continue;
+            }
+            std::fill(g.bits.begin(), g.bits.end(), 0);
+            auto entities = population.entities();
+            auto memory = population.memory();
+            for(std::size_t i = 0; i < population.size(); ++i){
+                Context ctx{entities[i], memory[i], world, population.board(), population.senses(), i, nullptr};
+                if(g.leaf(ctx, 0.0f) == Status::Success){ g.bits[i / 64] |= std::uint64_t{1} << (i % 64); }
+            }
+        }
+        std::fill(counts_.begin(), counts_.end(), 0);
+    }
+
+    // The root Selector's tick for ctx.index, from the guard bits.
+    Status tick(Context& ctx, float dt) noexcept{
+        const std::size_t patterns = std::size_t{1} << guards_.size();
+        std::size_t pattern = 0;
+        for(std::size_t g = 0; g < guards_.size(); ++g){
+            pattern |= static_cast<std::size_t>((guards_[g].bits[ctx.index / 64] >> (ctx.index % 64)) & 1u) << g;
+        }
+        for(std::size_t k = next_[pattern]; k < branches_.size(); k = next_[(k + 1) * patterns + pattern]){
+            const Branch& b = branches_[k];
+            Status s = Status::Success;
+            if(b.node->kind() == NodeKind::Sequence){
+                for(const Node* child : b.rest){
+                    s = child->tick(ctx, dt);
+                    if(s != Status::Success) break;
+                }
+            } else{
+                s = b.node->tick(ctx, dt);
+            }
+            if(s != Status::Failure){
+                ++counts_[k];
+                return s;
+            }
+        }
+        ++counts_[branches_.size()];
+        return Status::Failure;
+    }
+
+private:
+    struct Branch final{
+        const Node* node = nullptr;
+        std::uint32_t guards = 0;       //guard bits that must all be set
+        std::span<Node* const> rest{};  //the Sequence's children after its guards
+    };
+    struct Guard final{
+        LeafFn leaf = nullptr;
+        BatchConditionFn batch = nullptr;
+        std::vector<std::uint64_t> bits;
+    };
+
+    std::vector<Branch> branches_;
+    std::vector<Guard> guards_;
+    std::vector<std::uint8_t> next_;    //[branch][pattern]
+    std::vector<std::uint32_t> counts_;
+
+    // A pure condition; or, where every agent reaches it first, one that writes only its own keys.
+    static bool is_guard(const Node& n, bool asked_first) noexcept{
+        if(n.kind() != NodeKind::Leaf) return false;
+        const auto& traits = static_cast<const Leaf&>(n).traits;
+        if(traits.commutative) return true;
+        return asked_first && (traits.outcomes & outcome(Status::Running)) == 0 && traits.writes != reads_anything;
+    }
+
+    std::size_t guard_of(LeafFn leaf, std::span<const BatchCondition> kernels){
+        for(std::size_t g = 0; g < guards_.size(); ++g){
+            if(guards_[g].leaf == leaf) return g;
+        }
+        assert(guards_.size() < max_guards);
+        Guard g{leaf, nullptr, {}};
+        for(const auto& k : kernels){
+            if(k.leaf == leaf){ g.batch = k.batch; }
+        }
+        guards_.push_back(std::move(g));
+        return guards_.size() - 1;
+    }
+};
+
+// DemoTree's guards, batched (game-ai.hpp).
+static constexpr BatchCondition demo_batch_conditions[] = {
+    {ThreatNearby, ThreatNearbyBatch},
+    {CheckHunger, CheckHungerBatch},
+};
+
+// simulate() with the root decision made by a DecisionTable: the same step and the same result.
+static void simulate(World& world, DecisionTable& table, EntityPool& population, float dt) noexcept{
+    const bool flocking = prepare_step(world, population, dt);
+    table.evaluate(world, population);
+    auto entities = population.entities();
+    auto memory = population.memory();
+    auto& board = population.board();
+    auto& senses = population.senses();
+    for(std::size_t i = 0; i < entities.size(); ++i){
+        Context ctx{entities[i], memory[i], world, board, senses, i, &world.commands};
+        std::ignore = table.tick(ctx, dt);
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    apply_commands(world, population, {&world.commands, 1});
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+#include "blackboard.hpp"
+#include "perception.hpp"
+#include "linear-stat.hpp"
+#include "flocking.hpp"
+#include "spatial-order.hpp"
+#include "frame-arena.hpp"
+#include <utility>
+
+// Stable reference to an agent. The slot never moves; the generation is bumped every
+// time the slot is freed, so stale handles to despawned agents are detected.
+struct EntityHandle final{
+    static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t slot = invalid;
+    std::uint32_t generation = 0;
+
+    bool operator==(const EntityHandle&) const noexcept = default;
+};
+
+// Something scheduled to happen to one agent at a given world time (see TimerQueue).
+// `kind` is defined by the game rules that schedule it; despawned agents' events are dropped.
+struct AgentEvent final{
+    EntityHandle agent;
+    std::uint32_t kind = 0;
+};
+
+// Dense storage for the whole population.
+// entities[i], memory[i], row i of the blackboard and owner[i] always describe the same agent, so the tick loop
+// walks plain contiguous arrays. Despawning swaps the last agent into the hole; its hot
+// record and its BT memory move together, so composites resume exactly where they were.
+// Handles are translated to dense indices through the slot table, which is also what lets
+// sort_spatially() reorder the rows without invalidating anyone's handle.
+//
+// Do not spawn or despawn while iterating entities(); collect handles and apply them after the tick.
+struct EntityPool final{
+    EntityPool() = default;
+    explicit EntityPool(Blackboard board) : board_(std::move(board)){}
+
+    std::size_t size() const noexcept{ return entities_.size(); }
+    bool empty() const noexcept{ return entities_.empty(); }
+
+    std::span<Entity> entities() noexcept{ return entities_; }
+    std::span<const Entity> entities() const noexcept{ return entities_; }
+    std::span<EntityMemory> memory() noexcept{ return memory_; }
+    std::span<const EntityMemory> memory() const noexcept{ return memory_; }
+    Blackboard& board() noexcept{ return board_; }
+    const Blackboard& board() const noexcept{ return board_; }
+    Senses& senses() noexcept{ return senses_; } //rebuilt by perceive() every frame
+    const Senses& senses() const noexcept{ return senses_; }
+    NeighborGrid& neighbors() noexcept{ return neighbors_; } //rebuilt every frame while flocking is on
+    const NeighborGrid& neighbors() const noexcept{ return neighbors_; }
+    TimerQueue<AgentEvent>& timers() noexcept{ return timers_; }
+
+    // Handles spawned since the last call, so the simulation can initialize time-based state
+    // (e.g. schedule events) for new agents. Some may have been despawned again since.
+    // The list is in frame memory (frame-arena.hpp), valid until the next step.
+    FrameVector<EntityHandle> take_spawned(){
+        FrameVector<EntityHandle> out(spawned_.begin(), spawned_.end(), ArenaAllocator<EntityHandle>{frame_arena()});
+        spawned_.clear(); //keeps its capacity for the next spawns
+        return out;
+    }
+
+    EntityHandle spawn(const Entity& e, const EntityMemory& m = {}){
+        const auto handle = acquire_slot(static_cast<std::uint32_t>(entities_.size()));
+        entities_.push_back(e);
+        memory_.push_back(m);
+        owner_.push_back(handle.slot);
+        board_.append(1, nullptr);
+        spawned_.push_back(handle);
+        return handle;
+    }
+
+    // Spawns `count` randomized agents in one go: one reservation per array and one
+    // Rng stream, instead of a GetRandomValue call for every field of every agent.
+    // Handles are appended to `out` when given.
+    void spawn(std::size_t count, Rng& rng, std::vector<EntityHandle>* out = nullptr){
+        const std::size_t first = entities_.size();
+        entities_.reserve(first + count);
+        memory_.reserve(first + count);
+        owner_.reserve(first + count);
+        if(out){ out->reserve(out->size() + count); }
+        spawned_.reserve(spawned_.size() + count);
+        for(std::size_t i = 0; i < count; ++i){
+            entities_.push_back(Entity::random(rng));
+            memory_.emplace_back();
+            const auto handle = acquire_slot(static_cast<std::uint32_t>(first + i));
+            owner_.push_back(handle.slot);
+            spawned_.push_back(handle);
+            if(out){ out->push_back(handle); }
+        }
+        board_.append(count, &rng);
+    }
+
+    // Room for `count` agents in every per-agent array, senses included, so a population that
+    // grows and shrinks below that does not allocate.
+    void reserve(std::size_t count){
+        entities_.reserve(count);
+        memory_.reserve(count);
+        owner_.reserve(count);
+        slots_.reserve(count);
+        board_.reserve(count);
+        senses_.reserve(count);
+    }
+
+    bool despawn(EntityHandle h) noexcept{
+        if(!alive(h)) return false;
+        const std::uint32_t hole = slots_[h.slot].dense;
+        const std::uint32_t last = static_cast<std::uint32_t>(entities_.size() - 1);
+        if(hole != last){
+            entities_[hole] = entities_[last];
+            memory_[hole] = memory_[last];
+            owner_[hole] = owner_[last];
+            slots_[owner_[hole]].dense = hole;
+        }
+        board_.swap_remove(hole, last);
+        entities_.pop_back();
+        memory_.pop_back();
+        owner_.pop_back();
+        release_slot(h.slot);
+        return true;
+    }
+
+    bool alive(EntityHandle h) const noexcept{
+        return h.slot < slots_.size() && slots_[h.slot].generation == h.generation && slots_[h.slot].dense != free_marker;
+    }
+
+    // Dense index of a live handle; only valid until the next spawn/despawn.
+    std::size_t index_of(EntityHandle h) const noexcept{
+        assert(alive(h));
+        return slots_[h.slot].dense;
+    }
+
+    // Reorders the rows into Morton order of the agents' positions (spatial-order.hpp): entities,
+    // BT memory and blackboard rows move together, and the slot table follows them. Dense
+    // indices from before the call are stale; handles are not. Senses and the neighbor grid are
+    // rebuilt from the new rows by the next frame. Returns false if the rows already were in order.
+    bool sort_spatially(){
+        const auto order = morton_.order(entities_);
+        if(order.empty()) return false;
+        const std::size_t n = order.size();
+        sorted_entities_.resize(n);
+        sorted_memory_.resize(n);
+        sorted_owner_.resize(n);
+        for(std::size_t i = 0; i < n; ++i){
+            sorted_entities_[i] = entities_[order[i]];
+            sorted_memory_[i] = memory_[order[i]];
+            sorted_owner_[i] = owner_[order[i]];
+            slots_[sorted_owner_[i]].dense = static_cast<std::uint32_t>(i);
+        }
+        entities_.swap(sorted_entities_);
+        memory_.swap(sorted_memory_);
+        owner_.swap(sorted_owner_);
+        board_.permute(order);
+        return true;
+    }
+
+    EntityHandle handle_at(std::size_t index) const noexcept{
+        assert(index < owner_.size());
+        const std::uint32_t slot = owner_[index];
+        return {slot, slots_[slot].generation};
+    }
+
+    Entity* get(EntityHandle h) noexcept{
+        return alive(h) ? &entities_[slots_[h.slot].dense] : nullptr;
+    }
+
+    void clear() noexcept{
+        for(std::size_t i = entities_.size(); i-- > 0;){
+            release_slot(owner_[i]);
+        }
+        entities_.clear();
+        memory_.clear();
+        owner_.clear();
+        board_.clear();
+        timers_.clear();
+        spawned_.clear();
+    }
+
+private:
+    static constexpr std::uint32_t free_marker = std::numeric_limits<std::uint32_t>::max();
+
+    struct Slot final{
+        std::uint32_t dense = free_marker;  //index into the dense arrays, or free_marker
+        std::uint32_t generation = 1;       //starts at 1 so a default EntityHandle is never alive
+        std::uint32_t next_free = free_marker;
+    };
+
+    std::vector<Entity> entities_;
+    std::vector<EntityMemory> memory_;
+    std::vector<std::uint32_t> owner_;      //dense index -> slot
+    Blackboard board_;
+    Senses senses_;
+    NeighborGrid neighbors_;
+    MortonOrder morton_;
+    std::vector<Entity> sorted_entities_;   //sort_spatially()'s targets, swapped with the live arrays
+    std::vector<EntityMemory> sorted_memory_;
+    std::vector<std::uint32_t> sorted_owner_;
+    TimerQueue<AgentEvent> timers_;
+    std::vector<EntityHandle> spawned_;
+    std::vector<Slot> slots_;
+    std::uint32_t free_head_ = free_marker;
+
+    EntityHandle acquire_slot(std::uint32_t dense){
+        std::uint32_t slot = free_head_;
+        if(slot != free_marker){
+            free_head_ = slots_[slot].next_free;
+        } else{
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        slots_[slot].dense = dense;
+        return {slot, slots_[slot].generation};
+    }
+
+    void release_slot(std::uint32_t slot) noexcept{
+        slots_[slot].dense = free_marker;
+        ++slots_[slot].generation;
+        slots_[slot].next_free = free_head_;
+        free_head_ = slot;
+    }
+};
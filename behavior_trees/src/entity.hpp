@@ -1,29 +1,42 @@
 #pragma once
 #include "common.hpp"
+#include <cstdint>
 
-struct Entity final{
+// What the agent is currently doing. Written by the action leaves, mapped to text only by the renderer.
+enum class Activity : std::uint8_t{ None, Flee, Patrol, SeekFood };
+
+static constexpr const char* to_string(Activity a) noexcept{
+    switch(a){
+    case Activity::Flee: return "FLEE";
+    case Activity::Patrol: return "PATROL";
+    case Activity::SeekFood: return "SEEK FOOD";
+    default: return "None";
+    }
+}
+
+// Hot record: everything the BT tick and the integrator touch every frame.
+// Kept at 32 bytes so two agents share a cache line and none straddles one.
+struct alignas(32) Entity final{
     static constexpr float min_speed = 24.0f;
     static constexpr float max_speed = 200.0f;
-    static constexpr float hunger_per_second = 0.04f;
     static constexpr float drag = 0.01f;
     static constexpr float seek_weight = 1.0f;
     static constexpr float flee_weight = 1.2f;
 
-    // patrol mission
-    int waypoint_index = GetRandomValue(0, 3);    
-    std::array<int, 8> bt_mem{};
+    Vector2 position = ZERO;
+    Vector2 velocity = {min_speed, 0.0f};
+    Vector2 acceleration = ZERO;
 
-    // hunger mission
-    float hunger = random_range(0.0f, 1.0f);
-    bool isHungry = false;
+    Activity activity = Activity::None;
 
-    std::string_view debug_state = "None";    
-    Vector2 position = random_range(ZERO, STAGE_SIZE);
-    Vector2 acceleration = ZERO;
-    Vector2 velocity = vector_from_angle(random_range(0.0f, 2.0f * PI), min_speed);
+    static Entity random(Rng& rng) noexcept{
+        Entity e;
+        e.position = rng.range(ZERO, STAGE_SIZE);
+        e.velocity = vector_from_angle(rng.range(0.0f, 2.0f * PI), min_speed);
+        return e;
+    }
 
     void update(float dt) noexcept{
-        hunger = std::clamp(hunger + hunger_per_second * dt, 0.0f, 1.0f);
         velocity += acceleration * dt;
         velocity = Vector2ClampValue(velocity, min_speed, max_speed);
         position += velocity * dt;
@@ -31,15 +44,14 @@ struct Entity final{
         acceleration = ZERO;        
     }
 
-    void render() const noexcept{
-        Vector2 local_x = (Vector2Length(velocity) != 0) ? Vector2Normalize(velocity) : Vector2{1, 0};
-        Vector2 local_y = {-local_x.y, local_x.x};
-        float L = ENTITY_SIZE;
-        float H = ENTITY_SIZE;
-        Vector2 tip = position + (local_x * L * 1.4f);
-        Vector2 left = position - (local_x * L) + (local_y * H);
-        Vector2 right = position - (local_x * L) - (local_y * H);
-        auto alpha = 1.0f - hunger * 0.7f;
-        DrawTriangle(tip, right, left, Fade(GREEN, alpha));
+    Vector2 heading() const noexcept{
+        return (Vector2Length(velocity) != 0) ? Vector2Normalize(velocity) : Vector2{1, 0};
     }
-};
\ No newline at end of file
+};
+static_assert(sizeof(Entity) == 32, "keep the hot record at half a cache line");
+
+// Cold side table, stored parallel to the hot records (same index).
+// Per-node memory for the composites. Leaf state lives in the Blackboard.
+struct EntityMemory final{
+    std::array<int, 8> bt_mem{};
+};
@@ -0,0 +1,168 @@
+#pragma once
+#include "common.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+
+// FarField: full simulation only where it matters.
+//
+// An agent is relevant while it is near the wolf, near the viewer, or hungry and near the food.
+// Relevant agents are sensed, flocked, ticked and integrated as usual. The others are distant:
+// they skip all of it and follow a coarse model instead. Every `period` frames a distant agent
+// moves through a small state machine:
+//
+//   hungry                           -> SeekFood, along the food's flow field
+//   patrolling, reached the waypoint -> Patrol towards the next one (AdvanceCorner)
+//   otherwise                        -> Patrol towards WaypointIndex
+//
+// and gets the acceleration that takes its velocity, over the next period, to where steer_along()
+// would have taken it (the exponential approach to the desired velocity, in closed form). Each
+// frame in between it integrates that acceleration, without tree or flocking.
+//
+// Transitions come from the same state the tree reads (IsHungry from the hunger timers, which
+// keep running, and WaypointIndex), so nothing is sampled and nothing has to be made up on
+// promotion. Fleeing and eating never happen far away: the wolf and the food make agents
+// relevant first, with margin enough for one frame of closing in.
+//
+// Promotion keeps position and velocity, so nothing pops. BT memory is reset, so the patrol
+// resumes at MoveToCorner for the waypoint the coarse model got to. Demotion happens only
+// `hysteresis` further out than promotion, so agents on the border do not flap.
+//
+// Perception only senses runs of relevant rows, and flocking only the grid cells that hold a
+// relevant agent. The senses and forces of distant rows are stale, and nothing reads them.
+
+struct FarField final{
+    using Keys = KeySetWith<DemoTree::Keys, Distant>;
+    static constexpr std::uint32_t period = 8; //frames between a distant agent's coarse steps, staggered by row
+
+    Vector2 viewer = STAGE_SIZE * 0.5f; //the camera, or whatever else needs agents in full around it
+    float view_radius = 240.0f;
+    float wolf_margin = 64.0f;          //relevant this far outside the threat radius; agent and wolf close in ~10 px a frame
+    float food_radius = 96.0f;          //hungry agents this close to the food are relevant, so only relevant agents eat
+    float hysteresis = 48.0f;           //demoted only this much further out than promoted
+
+    // Rows of the last classify(), each in row order.
+    std::span<const std::uint32_t> full_rows() const noexcept{ return full_; }
+    std::span<const std::uint32_t> distant_rows() const noexcept{ return distant_; }
+    std::size_t promoted() const noexcept{ return promoted_; }
+    std::size_t demoted() const noexcept{ return demoted_; }
+
+    // Promotes and demotes. Call once per frame after advance() and before sense().
+    void classify(const World& world, EntityPool& population){
+        auto& board = population.board();
+        assert(board.has<Distant>() && "add Distant to the tree's KeySet (FarField::Keys)");
+        auto entities = population.entities();
+        auto memory = population.memory();
+        const auto distant = board.column<Distant>();
+        const auto hungry = board.column<IsHungry>();
+        const float wolf_radius = world.tuning.threat_radius + wolf_margin;
+        full_.clear();
+        distant_.clear();
+        full_.reserve(entities.size()); //between them they hold every row, in any split
+        distant_.reserve(entities.size());
+        promoted_ = demoted_ = 0;
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            const Vector2 p = entities[i].position;
+            float slack = Vector2Distance(p, viewer) - view_radius; //< 0: relevant
+            if(world.wolf_active){ slack = std::min(slack, Vector2Distance(p, world.wolf_pos) - wolf_radius); }
+            if(hungry[i]){ slack = std::min(slack, Vector2Distance(p, world.food_pos) - food_radius); }
+            if(distant[i] && slack < 0.0f){
+                distant[i] = false;
+                memory[i] = EntityMemory{};
+                entities[i].acceleration = ZERO; //the tree's to write again
+                ++promoted_;
+            } else if(!distant[i] && slack > hysteresis){
+                distant[i] = true;
+                entities[i].acceleration = ZERO; //until its first coarse step
+                ++demoted_;
+            }
+            (distant[i] ? distant_ : full_).push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+
+    // prepare_step()'s perception and flocking, for the relevant agents only. Returns whether
+    // flocking is on.
+    bool sense(const World& world, EntityPool& population){
+        auto entities = population.entities();
+        auto& senses = population.senses();
+        perceive_begin(world, entities.size(), senses);
+        for(std::size_t j = 0; j < full_.size();){ //runs of consecutive rows; the rows are in Morton order, so most are long
+            std::size_t k = j + 1;
+            while(k < full_.size() && full_[k] == full_[k - 1] + 1){ ++k; }
+            perceive_rows(world, entities, population.board(), senses, full_[j], full_[k - 1] + 1);
+            j = k;
+        }
+        if(!flocking_enabled(world.tuning)) return false;
+        auto& grid = population.neighbors();
+        grid.build(entities);
+        cells_.assign(NeighborGrid::cell_count, 0);
+        for(const auto i : full_){ cells_[NeighborGrid::cell_of(entities[i].position)] = 1; }
+        flock_rows(grid, world.tuning, 0, NeighborGrid::rows, NeighborGrid::max_candidates, cells_);
+        return true;
+    }
+
+    // Moves the distant agents: a coarse step for the rows whose turn it is, then a frame of drift.
+    void step(const World& world, EntityPool& population, float dt) noexcept{
+        auto& board = population.board();
+        auto entities = population.entities();
+        const std::uint32_t turn = world.frame % period;
+        for(const auto i : distant_){
+            Entity& e = entities[i];
+            if(i % period == turn){ coarse_step(world, board, i, e, dt * period); }
+            e.velocity = Vector2ClampValue(e.velocity + e.acceleration * dt, Entity::min_speed, Entity::max_speed); //as Entity::update, or promotion would snap it
+            e.position = wrap(e.position + e.velocity * dt);
+        }
+    }
+
+private:
+    std::vector<std::uint32_t> full_;
+    std::vector<std::uint32_t> distant_;
+    std::vector<std::uint8_t> cells_; //per neighbor grid cell: holds a relevant agent
+    std::size_t promoted_ = 0;
+    std::size_t demoted_ = 0;
+
+    static void coarse_step(const World& world, Blackboard& board, std::size_t row, Entity& e, float span) noexcept{
+        Vector2 dir = ZERO;
+        float speed = 0.0f;
+        if(board.get<IsHungry>(row)){
+            e.activity = Activity::SeekFood;
+            speed = Entity::max_speed * world.tuning.seek_speed;
+            dir = world.food_field.direction(e.position);
+        } else{
+            e.activity = Activity::Patrol;
+            speed = Entity::max_speed * world.tuning.patrol_speed;
+            int corner = board.get<WaypointIndex>(row);
+            const float reach = World::waypoint_radius + speed * span; //arrives before the next step
+            if(Vector2DistanceSqr(e.position, world.waypoints[corner]) <= reach * reach){
+                corner = (corner + 1) % static_cast<int>(world.waypoints.size());
+                board.set<WaypointIndex>(row, corner, world.frame);
+            }
+            dir = world.waypoint_fields[corner].direction(e.position);
+        }
+        // dv/dt = (desired - v) * seek_weight, solved over the span and spread evenly across it
+        const Vector2 desired = dir * speed;
+        const Vector2 target = desired + (e.velocity - desired) * std::exp(-Entity::seek_weight * span);
+        e.acceleration = (target - e.velocity) / span;
+    }
+};
+
+// simulate() with the far field: the relevant agents are sensed, flocked, ticked and integrated
+// as usual, the distant ones are moved by the coarse model.
+static void simulate(World& world, const EntityBrain& brain, FarField& far, EntityPool& population, float dt){
+    advance(world, population, dt);
+    far.classify(world, population);
+    const bool flocking = far.sense(world, population);
+    auto entities = population.entities();
+    auto memory = population.memory();
+    auto& board = population.board();
+    auto& senses = population.senses();
+    for(const std::size_t i : far.full_rows()){
+        Context ctx{entities[i], memory[i], world, board, senses, i, &world.commands};
+        std::ignore = brain.tick(ctx, dt);
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    far.step(world, population, dt);
+    apply_commands(world, population, {&world.commands, 1});
+}
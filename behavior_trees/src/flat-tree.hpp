@@ -0,0 +1,157 @@
+#pragma once
+#include "behavior-tree.hpp"
+#include <memory>
+
+// FlatTree: a whole tree in one allocation.
+//
+// The node-per-object trees (Sequence, Selector, ...) scatter their nodes wherever their owner
+// lives and give every composite its own std::vector of children. FlatTree copies such a tree
+// into one block: 16-byte node records in depth-first order, followed by one shared array of
+// child indices. A composite's children are a (first, count) span into that array, and a
+// composite's first child is always the very next record, so a tick mostly walks forward
+// through contiguous memory. Loading is one allocation, destroying is one free.
+//
+// Ticking interprets the records with a switch instead of a virtual call per node. Semantics
+// are those of the source nodes; anything the builder does not know (coroutine leaves,
+// CachedSubtree, ...) is kept as a borrowed pointer and ticked through its vtable.
+//
+//   DemoTree source;
+//   FlatTree flat{source.root};
+//   EntityBrain brain{&flat};   //FlatTree is itself a Node
+
+struct FlatTree final : Node{
+    struct Record final{
+        NodeKind kind = NodeKind::Opaque;
+        std::uint8_t mem_slot = 0;     //MemorySequence
+        std::uint16_t unused = 0;
+        std::uint32_t child_count = 0;
+        union{
+            std::uint32_t first_child; //index into the child array (composites)
+            LeafFn fn;                 //Leaf
+            const Node* borrowed;      //Opaque
+        };
+        Record() noexcept : first_child(0){}
+    };
+    static_assert(sizeof(Record) == 16);
+
+    explicit FlatTree(const Node& root){
+        std::size_t nodes = 0, links = 0;
+        count(root, nodes, links);
+        node_count_ = static_cast<std::uint32_t>(nodes);
+        link_count_ = static_cast<std::uint32_t>(links);
+        storage_ = std::make_unique<std::byte[]>(bytes());
+        records_ = std::uninitialized_value_construct_n(reinterpret_cast<Record*>(storage_.get()), nodes) - nodes;
+        links_ = reinterpret_cast<std::uint32_t*>(storage_.get() + nodes * sizeof(Record));
+        std::uint32_t next_node = 0, next_link = 0;
+        std::ignore = emit(root, next_node, next_link);
+        assert(next_node == node_count_ && next_link == link_count_);
+    }
+
+    Status tick(Context& ctx, float dt) const noexcept override{ return visit(0, ctx, dt); }
+
+    std::size_t node_count() const noexcept{ return node_count_; }
+    std::size_t bytes() const noexcept{ return node_count_ * sizeof(Record) + link_count_ * sizeof(std::uint32_t); }
+    std::span<const Record> records() const noexcept{ return {records_, node_count_}; }
+
+private:
+    std::unique_ptr<std::byte[]> storage_;
+    Record* records_ = nullptr;
+    std::uint32_t* links_ = nullptr;
+    std::uint32_t node_count_ = 0;
+    std::uint32_t link_count_ = 0;
+
+    static bool is_composite(NodeKind k) noexcept{
+        return k == NodeKind::Sequence || k == NodeKind::Selector || k == NodeKind::MemorySequence || k == NodeKind::RepeatForever;
+    }
+
+    static void count(const Node& n, std::size_t& nodes, std::size_t& links) noexcept{
+        ++nodes;
+        if(!is_composite(n.kind())) return;
+        links += n.subtrees().size();
+        for(const Node* c : n.subtrees()){ count(*c, nodes, links); }
+    }
+
+    // Writes `n` and its subtree in depth-first order; returns the index of `n`'s record.
+    std::uint32_t emit(const Node& n, std::uint32_t& next_node, std::uint32_t& next_link) noexcept{
+        const std::uint32_t self = next_node++;
+        Record& r = records_[self];
+        r.kind = n.kind();
+        switch(r.kind){
+        case NodeKind::Leaf:
+            r.fn = static_cast<const Leaf&>(n).fn;
+            return self;
+        case NodeKind::MemorySequence:
+            assert(static_cast<const MemorySequence&>(n).mem_slot < 256);
+            r.mem_slot = static_cast<std::uint8_t>(static_cast<const MemorySequence&>(n).mem_slot);
+            break;
+        case NodeKind::Sequence:
+        case NodeKind::Selector:
+        case NodeKind::RepeatForever:
+            break;
+        default:
+            r.kind = NodeKind::Opaque;
+            r.borrowed = &n;
+            return self;
+        }
+        const auto kids = n.subtrees();
+        const std::uint32_t first = next_link;
+        next_link += static_cast<std::uint32_t>(kids.size());
+        records_[self].first_child = first;
+        records_[self].child_count = static_cast<std::uint32_t>(kids.size());
+        for(std::size_t i = 0; i < kids.size(); ++i){
+            links_[first + i] = emit(*kids[i], next_node, next_link);
+        }
+        return self;
+    }
+
+    // One shared switch on the record's kind; the composites call back into it for each child.
+    // The compiler may inline it into their loops, but nothing here relies on that.
+    Status visit(std::uint32_t index, Context& ctx, float dt) const noexcept{
+        const Record& r = records_[index];
+        switch(r.kind){
+        case NodeKind::Leaf: return r.fn(ctx, dt);
+        case NodeKind::Sequence: return sequence(r, ctx, dt);
+        case NodeKind::Selector: return selector(r, ctx, dt);
+        case NodeKind::MemorySequence: return memory_sequence(r, ctx, dt);
+        case NodeKind::RepeatForever: return repeat_forever(r, ctx, dt);
+        default: return r.borrowed->tick(ctx, dt);
+        }
+    }
+
+    Status sequence(const Record& r, Context& ctx, float dt) const noexcept{
+        for(std::uint32_t i = 0; i < r.child_count; ++i){
+            const Status s = visit(links_[r.first_child + i], ctx, dt);
+            if(s != Status::Success) return s;
+        }
+        return Status::Success;
+    }
+
+    Status selector(const Record& r, Context& ctx, float dt) const noexcept{
+        for(std::uint32_t i = 0; i < r.child_count; ++i){
+            const Status s = visit(links_[r.first_child + i], ctx, dt);
+            if(s != Status::Failure) return s;
+        }
+        return Status::Failure;
+    }
+
+    Status memory_sequence(const Record& r, Context& ctx, float dt) const noexcept{
+        assert(r.mem_slot < ctx.memory.bt_mem.size());
+        int& i = ctx.memory.bt_mem[r.mem_slot];
+        while(i < static_cast<int>(r.child_count)){
+            const Status s = visit(links_[r.first_child + static_cast<std::uint32_t>(i)], ctx, dt);
+            if(s == Status::Running) return Status::Running;
+            if(s == Status::Failure){
+                i = 0;
+                return Status::Failure;
+            }
+            ++i;
+        }
+        i = 0;
+        return Status::Success;
+    }
+
+    Status repeat_forever(const Record& r, Context& ctx, float dt) const noexcept{
+        std::ignore = visit(links_[r.first_child], ctx, dt);
+        return Status::Running;
+    }
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+#include "simd.hpp"
+#include "steering.hpp"
+#include "tuning.hpp"
+
+// Agent-agent steering: separation, alignment and cohesion (Reynolds' boids) between all agents,
+// added on top of whatever the tree steered each agent toward.
+//
+// Neighbors come from a NeighborGrid: positions and velocities copied into cells of the
+// neighbor radius and sorted by cell (a counting sort), so an agent only looks at the 3x3
+// cells around its own. Cells are stored row-major, which makes the three cells of each row
+// one contiguous run of candidates. Every agent of a cell shares those candidates, so the kernel
+// runs simd::width agents of the cell at once against one candidate at a time: no horizontal
+// sums, and the candidates stay in L1 while the cell is processed.
+//
+// At most `max_candidates` entries are looked at per cell (its own row of cells first), so a
+// crowd packed tighter than separation can resolve costs O(N * max_candidates), never O(N^2).
+//
+// The forces only depend on the snapshot, so they are computed for everyone before the tick
+// and added by flock() afterwards (leaves may reset the acceleration). Neighbors are not
+// searched across the stage edges, even though agents wrap around them.
+
+struct NeighborGrid final{
+    static constexpr float radius = 2.0f * ENTITY_SIZE; //neighbor radius, and the cell size
+    static constexpr int cols = static_cast<int>(STAGE_WIDTH / radius) + 1;
+    static constexpr int rows = static_cast<int>(STAGE_HEIGHT / radius) + 1;
+    static constexpr int cell_count = cols * rows;
+    static constexpr std::size_t max_candidates = 64;
+    static constexpr float far = 1e9f; //position of the padding
+
+    // Sorted by cell; cell c holds entries [start[c], start[c + 1]). The columns carry simd::width
+    // entries of padding far off stage, so kernels can always load whole blocks.
+    std::vector<std::uint32_t> start;
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> vel_x;
+    std::vector<float> vel_y;
+    std::vector<std::uint32_t> row;   //dense row of each entry
+
+    // per dense row: the flocking force, filled by flock_rows()
+    std::vector<float> force_x;
+    std::vector<float> force_y;
+
+    static int cell_of(Vector2 p) noexcept{
+        constexpr float inv = 1.0f / radius;
+        return std::clamp(to_int(p.y * inv), 0, rows - 1) * cols + std::clamp(to_int(p.x * inv), 0, cols - 1);
+    }
+
+    std::size_t size() const noexcept{ return row.size(); }
+
+    // Snapshot of every agent's position and velocity. Reuses its capacity.
+    void build(std::span<const Entity> entities){
+        const std::size_t n = entities.size();
+        cell_.resize(n);
+        start.assign(cell_count + 1, 0);
+        for(std::size_t i = 0; i < n; ++i){
+            const auto c = static_cast<std::uint32_t>(cell_of(entities[i].position));
+            cell_[i] = c;
+            ++start[c + 1];
+        }
+        for(int c = 0; c < cell_count; ++c){ start[c + 1] += start[c]; }
+        pos_x.assign(n + simd::width, far);
+        pos_y.assign(n + simd::width, far);
+        vel_x.assign(n + simd::width, 0.0f);
+        vel_y.assign(n + simd::width, 0.0f);
+        row.resize(n);
+        force_x.assign(n, 0.0f);
+        force_y.assign(n, 0.0f);
+        cursor_.assign(start.begin(), start.end() - 1);
+        for(std::size_t i = 0; i < n; ++i){
+            const std::uint32_t slot = cursor_[cell_[i]]++;
+            pos_x[slot] = entities[i].position.x;
+            pos_y[slot] = entities[i].position.y;
+            vel_x[slot] = entities[i].velocity.x;
+            vel_y[slot] = entities[i].velocity.y;
+            row[slot] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+private:
+    std::vector<std::uint32_t> cell_;
+    std::vector<std::uint32_t> cursor_;
+};
+
+// What an agent's neighbors add up to. Offsets are neighbor minus self.
+struct NeighborSums final{
+    float count = 0.0f;
+    Vector2 offset = ZERO;      //sum of offsets: count * (center of the neighbors - self)
+    Vector2 velocity = ZERO;    //sum of velocities
+    Vector2 away = ZERO;        //sum of -offset / distance^2: points away from the crowd, nearer neighbors weigh more
+};
+
+static Vector2 steer_flock(const Entity& e, const NeighborSums& n, const Tuning& t) noexcept{
+    if(n.count == 0.0f) return ZERO;
+    Vector2 force = ZERO;
+    if(t.separation_weight > 0.0f && Vector2LengthSqr(n.away) > 0.0f){
+        force += steer_along(e, Vector2Normalize(n.away), Entity::max_speed, t.separation_weight);
+    }
+    if(t.alignment_weight > 0.0f){
+        force += (n.velocity * (1.0f / n.count) - e.velocity) * t.alignment_weight;
+    }
+    if(t.cohesion_weight > 0.0f && Vector2LengthSqr(n.offset) > 0.0f){
+        force += steer_along(e, Vector2Normalize(n.offset), Entity::max_speed, t.cohesion_weight);
+    }
+    return force;
+}
+
+static bool flocking_enabled(const Tuning& t) noexcept{
+    return t.separation_weight > 0.0f || t.alignment_weight > 0.0f || t.cohesion_weight > 0.0f;
+}
+
+// Neighbor sums of simd::width consecutive grid entries; lane k is entry first + k.
+struct NeighborLanes final{
+    alignas(32) float count[simd::width];
+    alignas(32) float offset_x[simd::width];
+    alignas(32) float offset_y[simd::width];
+    alignas(32) float velocity_x[simd::width];
+    alignas(32) float velocity_y[simd::width];
+    alignas(32) float away_x[simd::width];
+    alignas(32) float away_y[simd::width];
+
+    NeighborSums operator[](std::size_t k) const noexcept{
+        return {count[k], {offset_x[k], offset_y[k]}, {velocity_x[k], velocity_y[k]}, {away_x[k], away_y[k]}};
+    }
+};
+
+using CandidateSpan = std::pair<std::uint32_t, std::uint32_t>; //grid entries [first, second)
+
+// Sums entries [first, first + simd::width) against every candidate within the radius, excluding
+// each agent itself by its entry index. Agents on exactly the same spot have no direction apart,
+// so separation pushes them along x, the lower entry one way and the higher the other; that case
+// is rare and gets a second pass. Lanes past the end of the cell are computed too, and ignored
+// by the caller.
+static void gather_neighbors(const NeighborGrid& g, std::size_t first, std::span<const CandidateSpan> candidates, NeighborLanes& out) noexcept{
+    using namespace simd;
+    const f32 zero = set1(0.0f), one = set1(1.0f);
+    const f32 r2 = set1(NeighborGrid::radius * NeighborGrid::radius);
+    const f32 px = load(&g.pos_x[first]), py = load(&g.pos_y[first]);
+    f32 count = zero, ox = zero, oy = zero, vx = zero, vy = zero, ax = zero, ay = zero;
+    f32 spot = zero; //candidates on the lane's exact spot, itself included
+    for(const auto& [begin, end] : candidates){
+        for(std::uint32_t j = begin; j < end; ++j){
+            const f32 dx = set1(g.pos_x[j]) - px;
+            const f32 dy = set1(g.pos_y[j]) - py;
+            const f32 d2 = dx * dx + dy * dy;
+            const f32 apart = greater(d2, zero);
+            const f32 near = select(apart, less(d2, r2), zero); //in range, and not on the same spot
+            const f32 r = rsqrt(max(d2, one)); //clamped for agents closer than a pixel
+            const f32 inv = select(near, r * r, zero); //1/d^2
+            count = count + select(near, one, zero);
+            ox = ox + select(near, dx, zero);
+            oy = oy + select(near, dy, zero);
+            vx = vx + select(near, set1(g.vel_x[j]), zero);
+            vy = vy + select(near, set1(g.vel_y[j]), zero);
+            ax = ax - dx * inv;
+            ay = ay - dy * inv;
+            spot = spot + select(apart, zero, one);
+        }
+    }
+    if(bits(greater(spot, one)) != 0){ //some lane shares its spot with another agent
+        alignas(32) float lanes[simd::width];
+        for(std::size_t k = 0; k < simd::width; ++k){ lanes[k] = static_cast<float>(first + k); } //exact below 2^24 entries
+        const f32 self = load(lanes);
+        for(const auto& [begin, end] : candidates){
+            for(std::uint32_t j = begin; j < end; ++j){
+                const f32 dx = set1(g.pos_x[j]) - px;
+                const f32 dy = set1(g.pos_y[j]) - py;
+                const f32 dj = set1(static_cast<float>(j)) - self;
+                const f32 same = select(greater(dx * dx + dy * dy, zero), zero, greater(dj * dj, zero)); //on the spot, and not itself
+                count = count + select(same, one, zero);
+                vx = vx + select(same, set1(g.vel_x[j]), zero);
+                vy = vy + select(same, set1(g.vel_y[j]), zero);
+                ax = ax - select(same, select(greater(dj, zero), one, zero - one), zero); //a pixel apart, by entry order
+            }
+        }
+    }
+    store(out.count, count);
+    store(out.offset_x, ox);
+    store(out.offset_y, oy);
+    store(out.velocity_x, vx);
+    store(out.velocity_y, vy);
+    store(out.away_x, ax);
+    store(out.away_y, ay);
+}
+
+// Candidates of cell (cx, cy): the three cells around it on its own row, then on the rows above
+// and below, cut off after `max_candidates` entries. Returns how many spans were written.
+static std::size_t candidates_of(const NeighborGrid& g, int cx, int cy, std::size_t max_candidates, std::array<CandidateSpan, 3>& out) noexcept{
+    constexpr int cols = NeighborGrid::cols;
+    const int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, cols - 1);
+    std::size_t budget = max_candidates, used = 0;
+    for(const int dy : {0, -1, 1}){
+        const int y = cy + dy;
+        if(y < 0 || y >= NeighborGrid::rows || budget == 0) continue;
+        const std::uint32_t begin = g.start[y * cols + x0];
+        const auto end = static_cast<std::uint32_t>(std::min<std::size_t>(g.start[y * cols + x1 + 1], begin + budget));
+        budget -= end - begin;
+        out[used++] = {begin, end};
+    }
+    return used;
+}
+
+// Fills force_x/force_y for the agents in cell rows [first_row, last_row). Each call only writes
+// its own agents, so the rows can be split over threads. With `cells`, only the cells flagged
+// there are computed; the forces of the other agents are left stale (see FarField).
+static void flock_rows(NeighborGrid& g, const Tuning& t, int first_row, int last_row, std::size_t max_candidates = NeighborGrid::max_candidates, std::span<const std::uint8_t> cells = {}) noexcept{
+    std::array<CandidateSpan, 3> spans{};
+    NeighborLanes lanes;
+    for(int cy = first_row; cy < last_row; ++cy){
+        for(int cx = 0; cx < NeighborGrid::cols; ++cx){
+            const int c = cy * NeighborGrid::cols + cx;
+            const std::uint32_t end = g.start[c + 1];
+            if(g.start[c] == end || (!cells.empty() && cells[c] == 0)) continue;
+            const std::size_t used = candidates_of(g, cx, cy, max_candidates, spans);
+            for(std::uint32_t first = g.start[c]; first < end; first += simd::width){
+                gather_neighbors(g, first, {spans.data(), used}, lanes);
+                for(std::uint32_t k = 0; k < std::min<std::uint32_t>(simd::width, end - first); ++k){
+                    Entity e; //steer_flock reads the velocity
+                    e.velocity = {g.vel_x[first + k], g.vel_y[first + k]};
+                    const Vector2 f = steer_flock(e, lanes[k], t);
+                    g.force_x[g.row[first + k]] = f.x;
+                    g.force_y[g.row[first + k]] = f.y;
+                }
+            }
+        }
+    }
+}
+
+// Adds the force flock_rows() computed for dense row `row`. Call after the agent's tree was ticked.
+static void flock(const NeighborGrid& g, Entity& e, std::size_t row) noexcept{
+    e.acceleration += Vector2{g.force_x[row], g.force_y[row]};
+}
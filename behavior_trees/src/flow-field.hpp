@@ -0,0 +1,215 @@
+#pragma once
+#include "common.hpp"
+#include <cstdint>
+
+// Flow fields: one shared navigation field per goal, so agents never path-find on their own.
+// A field is built once (Dijkstra outward from the goal cell) and every agent then
+// samples its direction with a single cell lookup.
+//
+// Cells that can see the goal in a straight line are flagged, and agents standing in
+// them steer straight at the goal from their exact position. With no obstacles every
+// cell qualifies, the build is skipped entirely, and the result is identical to the
+// plain straight-line seek the leaves used before.
+
+struct FlowGrid final{
+    static constexpr float cell_size = 20.0f;
+    static constexpr int cols = STAGE_WIDTH / 20;
+    static constexpr int rows = STAGE_HEIGHT / 20;
+    static constexpr int cell_count = cols * rows;
+
+    std::vector<std::uint8_t> blocked = std::vector<std::uint8_t>(cell_count, 0);
+    int obstacle_count = 0;
+    std::uint32_t version = 0; //bumped whenever obstacles change, so fields know to rebuild
+
+    static int cell_of(Vector2 p) noexcept{
+        constexpr float inv_size = 1.0f / cell_size;
+        const int x = std::clamp(to_int(p.x * inv_size), 0, cols - 1);
+        const int y = std::clamp(to_int(p.y * inv_size), 0, rows - 1);
+        return y * cols + x;
+    }
+
+    static Vector2 center_of(int cell) noexcept{
+        return {(to_float(cell % cols) + 0.5f) * cell_size, (to_float(cell / cols) + 0.5f) * cell_size};
+    }
+
+    bool is_blocked(int x, int y) const noexcept{
+        return x < 0 || y < 0 || x >= cols || y >= rows || blocked[y * cols + x] != 0;
+    }
+
+    void block(Rectangle r) noexcept{
+        const int x0 = std::max(0, to_int(r.x / cell_size));
+        const int y0 = std::max(0, to_int(r.y / cell_size));
+        const int x1 = std::min(cols - 1, to_int(std::ceil((r.x + r.width) / cell_size)) - 1);
+        const int y1 = std::min(rows - 1, to_int(std::ceil((r.y + r.height) / cell_size)) - 1);
+        for(int y = y0; y <= y1; ++y){
+            for(int x = x0; x <= x1; ++x){
+                auto& b = blocked[y * cols + x];
+                obstacle_count += (b == 0) ? 1 : 0;
+                b = 1;
+            }
+        }
+        ++version;
+    }
+
+    void clear() noexcept{
+        std::fill(blocked.begin(), blocked.end(), std::uint8_t{0});
+        obstacle_count = 0;
+        ++version;
+    }
+
+    // Walks the cells between a and b (supercover DDA). Only used while building fields.
+    bool line_of_sight(int a, int b) const noexcept{
+        int x = a % cols, y = a / cols;
+        const int tx = b % cols, ty = b / cols;
+        const int dx = std::abs(tx - x), dy = std::abs(ty - y);
+        const int sx = (tx > x) ? 1 : -1, sy = (ty > y) ? 1 : -1;
+        int err = dx - dy;
+        for(int steps = dx + dy; steps > 0; --steps){
+            if(is_blocked(x, y)) return false;
+            const int e2 = 2 * err;
+            if(e2 > -dy){ err -= dy; x += sx; } else{ err += dx; y += sy; }
+        }
+        return !is_blocked(x, y);
+    }
+};
+
+struct FlowField final{
+    static constexpr std::uint16_t unreachable = 0xFFFF;
+    static constexpr std::uint16_t straight_cost = 10;
+    static constexpr std::uint16_t diagonal_cost = 14;
+
+    struct Cell final{
+        Vector2 dir = ZERO;          //unit vector toward the next cell on the way to the goal
+        std::uint16_t cost = unreachable;
+        std::uint8_t los = 0;        //cell can see the goal: steer straight at it
+    };
+
+    float radius = 0.0f;             //0 = the whole grid, otherwise stop expanding beyond this distance
+
+    FlowField() noexcept = default;
+    explicit FlowField(float max_radius) noexcept : radius(max_radius){}
+
+    // Moves the goal. Within the same cell (or without obstacles) this is free;
+    // otherwise a rebuild is started and finished by update() over the next frame(s).
+    // Agents keep sampling the previous field until the new one is complete.
+    void set_goal(const FlowGrid& grid, Vector2 pos) noexcept{
+        target = pos;
+        const int cell = FlowGrid::cell_of(pos);
+        if(grid.obstacle_count == 0){
+            goal = pos;
+            trivial = true;
+            built_version = grid.version;
+            building = false;
+            return;
+        }
+        if(built_version == grid.version){
+            if(building && cell == pending_cell) return; //finish() picks up the new target
+            if(!building && !trivial && cell == goal_cell){
+                goal = pos;
+                return;
+            }
+        }
+        start_build(grid, cell);
+    }
+
+    // Advances a pending build by up to `budget` cells. Returns true while work remains.
+    bool update(const FlowGrid& grid, int budget) noexcept{
+        if(built_version != grid.version){
+            set_goal(grid, target);
+        }
+        if(!building) return false;
+        while(budget-- > 0 && !open.empty()){
+            std::pop_heap(open.begin(), open.end(), std::greater<>{});
+            const auto [cost, cell] = open.back();
+            open.pop_back();
+            if(cost != back[cell].cost) continue; //stale heap entry
+            if(back[cell].los && cell != pending_cell){ //only cells whose parent sees the goal can see it too
+                back[cell].los = grid.line_of_sight(cell, pending_cell) ? 1 : 0;
+            }
+            expand(grid, cell);
+        }
+        if(open.empty()){
+            finish(grid);
+        }
+        return building;
+    }
+
+    // O(1): one cell lookup, plus a normalize when the cell can see the goal.
+    // Cells the field does not reach (blocked, or beyond the radius) fall back to
+    // the straight line. Returns ZERO only when standing exactly on the goal.
+    Vector2 direction(Vector2 from) const noexcept{
+        if(!trivial){
+            const Cell& c = cells[FlowGrid::cell_of(from)];
+            if(c.cost != unreachable && !c.los) return c.dir;
+        }
+        return Vector2Normalize(goal - from);
+    }
+
+    // direction() for callers that already have the straight line to the goal (the batch
+    // perception pass): skips the normalize. Only while no rebuild is pending, since until
+    // the rebuild finishes the field still steers toward the previous goal.
+    Vector2 direction(Vector2 from, Vector2 straight) const noexcept{
+        assert(!building);
+        if(!trivial){
+            const Cell& c = cells[FlowGrid::cell_of(from)];
+            if(c.cost != unreachable && !c.los) return c.dir;
+        }
+        return straight;
+    }
+
+    bool is_building() const noexcept{ return building; }
+    bool is_trivial() const noexcept{ return trivial; } //direction() is the straight line everywhere
+
+private:
+    Vector2 goal = ZERO;             //goal the active field was built for
+    Vector2 target = ZERO;           //most recently requested goal
+    int goal_cell = -1;
+    int pending_cell = -1;
+    std::uint32_t built_version = 0;
+    bool trivial = true;
+    bool building = false;
+    std::vector<Cell> cells;         //active field, sampled by agents
+    std::vector<Cell> back;          //field under construction
+    std::vector<std::pair<std::uint16_t, int>> open; //Dijkstra frontier (min-heap on cost)
+
+    void start_build(const FlowGrid& grid, int cell) noexcept{
+        back.assign(FlowGrid::cell_count, Cell{});
+        open.clear();
+        pending_cell = cell;
+        built_version = grid.version;
+        building = true;
+        back[cell].cost = 0;
+        back[cell].los = 1;
+        open.emplace_back(std::uint16_t{0}, cell);
+    }
+
+    void expand(const FlowGrid& grid, int cell) noexcept{
+        static constexpr int offsets[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+        const int cx = cell % FlowGrid::cols, cy = cell / FlowGrid::cols;
+        const auto max_cost = (radius > 0.0f) ? to_int(radius / FlowGrid::cell_size * straight_cost) : int{unreachable} - 1;
+        for(const auto& o : offsets){
+            const int nx = cx + o[0], ny = cy + o[1];
+            if(grid.is_blocked(nx, ny)) continue;
+            const bool diagonal = o[0] != 0 && o[1] != 0;
+            if(diagonal && (grid.is_blocked(cx + o[0], cy) || grid.is_blocked(cx, cy + o[1]))) continue; //no corner cutting
+            const int cost = back[cell].cost + (diagonal ? diagonal_cost : straight_cost);
+            if(cost > max_cost) continue;
+            const int next = ny * FlowGrid::cols + nx;
+            Cell& n = back[next];
+            if(cost >= n.cost) continue;
+            n.cost = static_cast<std::uint16_t>(cost);
+            n.dir = Vector2Normalize(FlowGrid::center_of(cell) - FlowGrid::center_of(next));
+            n.los = back[cell].los;
+            open.emplace_back(n.cost, next);
+            std::push_heap(open.begin(), open.end(), std::greater<>{});
+        }
+    }
+
+    void finish(const FlowGrid& grid) noexcept{
+        cells.swap(back);
+        goal_cell = pending_cell;
+        goal = target;
+        trivial = grid.obstacle_count == 0;
+        building = false;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include "common.hpp"
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// FrameArena: memory for data that lives one simulation step, handed out by bumping a pointer.
+//
+// Nothing is freed on its own; reset() takes everything back at once, at the start of the next
+// step. When a step needed more than one block, reset() replaces them with a single block of
+// their combined size, so after a few frames every step fits the first block and the arena stops
+// calling operator new.
+//
+// One arena per thread (frame_arena()), so allocating takes no lock. advance() rewinds the
+// simulation thread's arena; JobSystem::run() rewinds each thread's as it joins a run, and
+// reserve()s it to the largest arena among its threads. Frame memory must not be held across
+// either: the handles from EntityPool::take_spawned(), say.
+//
+// ArenaAllocator adapts an arena to the standard containers, e.g. FrameVector<T>. Freeing the
+// most recent allocation hands it back, so scratch that is released before anything else is
+// allocated (a local FrameVector, say) does not add to the step's total.
+
+struct FrameArena final{
+    static constexpr std::size_t min_block = 64 * 1024;
+
+    FrameArena() noexcept = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align){
+        assert(align != 0 && (align & (align - 1)) == 0);
+        for(;; next_block(bytes + align)){
+            if(block_ == blocks_.size()) continue;
+            const Block& b = blocks_[block_];
+            const auto base = reinterpret_cast<std::uintptr_t>(b.data.get());
+            const std::size_t at = ((base + used_ + align - 1) & ~(std::uintptr_t{align} - 1)) - base;
+            if(at + bytes > b.size) continue;
+            in_use_ += at + bytes - used_;
+            used_ = at + bytes;
+            high_water_ = std::max(high_water_, in_use_);
+            return b.data.get() + at;
+        }
+    }
+
+    // Only the last allocation is handed back; anything else waits for reset().
+    void deallocate(void* p, std::size_t bytes) noexcept{
+        if(block_ == blocks_.size()) return;
+        std::byte* const top = blocks_[block_].data.get() + used_;
+        if(static_cast<std::byte*>(p) + bytes == top){
+            used_ -= bytes;
+            in_use_ -= bytes;
+        }
+    }
+
+    // Takes back everything handed out since the last reset().
+    void reset(){
+        if(blocks_.size() > 1){
+            std::size_t total = 0;
+            for(const Block& b : blocks_){ total += b.size; }
+            blocks_.clear();
+            blocks_.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(total), total});
+        }
+        block_ = 0;
+        used_ = 0;
+        in_use_ = 0;
+    }
+
+    // Grows the arena to one block of at least `bytes`, so a step that needs that much does not
+    // call operator new. Only right after reset(), while nothing is handed out.
+    void reserve(std::size_t bytes){
+        assert(in_use_ == 0 && "reserve() right after reset()");
+        if(capacity() >= bytes) return;
+        blocks_.clear();
+        blocks_.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(bytes), bytes});
+        block_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t in_use() const noexcept{ return in_use_; }
+    std::size_t high_water() const noexcept{ return high_water_; } //most bytes in use between two resets
+    std::size_t capacity() const noexcept{
+        std::size_t total = 0;
+        for(const Block& b : blocks_){ total += b.size; }
+        return total;
+    }
+    std::size_t blocks() const noexcept{ return blocks_.size(); }
+
+private:
+    struct Block final{
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size = 0;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t block_ = 0;      //the block being bumped; blocks_.size() before the first allocation
+    std::size_t used_ = 0;       //bytes of it handed out
+    std::size_t in_use_ = 0;     //bytes handed out since reset(), padding included
+    std::size_t high_water_ = 0;
+
+    void next_block(std::size_t at_least){
+        if(block_ < blocks_.size()){
+            ++block_;
+            used_ = 0;
+        }
+        if(block_ < blocks_.size() && blocks_[block_].size >= at_least) return;
+        const std::size_t size = std::max({at_least, min_block, capacity()}); //doubles the arena
+        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(block_), Block{std::make_unique_for_overwrite<std::byte[]>(size), size});
+    }
+};
+
+// The calling thread's arena.
+inline FrameArena& frame_arena() noexcept{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+template <typename T>
+struct ArenaAllocator{ //not final: containers derive from their allocator
+    using value_type = T;
+
+    FrameArena* arena = nullptr;
+
+    explicit ArenaAllocator(FrameArena& a) noexcept : arena(&a){}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena){}
+
+    T* allocate(std::size_t n){
+        if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length{};
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept{ arena->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept{ return arena == other.arena; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
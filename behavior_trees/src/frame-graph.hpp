@@ -0,0 +1,109 @@
+#pragma once
+#include "common.hpp"
+#include "job-system.hpp"
+#include "simulation.hpp"
+#include "frame-pipeline.hpp"
+
+// simulate() as a task graph, so the population is stepped on every core:
+//
+//   sort -All-> world -All-> perceive[c] -Chunk-> tick[c] -Chunk-> integrate[c] -All-> commands -All-> snapshot[c]
+//   sort -All-> neighbors -All-> flock[r] -All-> tick[c]
+//
+// A chunk of agents moves on to the next stage as soon as it is done with the previous one;
+// only the world update and the deferred world writes (commands) are barriers. Each tick chunk
+// has its own WorldCommands buffer, and the buffers are applied in chunk order, so the result is
+// bit-identical to simulate() for any number of threads and any chunk size.
+//
+// Leaves must only write their own agent, its blackboard row and ctx.commands (DemoTree does).
+// Trees with shared mutable state in their nodes (CoroutineDemoTree's arena, CachedSubtree's
+// statistics) must keep using simulate().
+//
+// Steering is computed inside the action leaves here, so it is part of the tick stage, and so is
+// adding the flocking force. The grid and the forces only need last frame's positions, so they are
+// computed next to the world update and perception (flock is chunked by rows of grid cells).
+
+struct SimulationGraph final{
+    static constexpr std::size_t default_chunk_rows = 1024; //a multiple of the SIMD width keeps perception off the tail path
+
+    SimulationGraph(World& world, const EntityBrain& brain, EntityPool& population, std::size_t chunk_rows = default_chunk_rows)
+        : world_(world), brain_(brain), population_(population), chunk_rows_(chunk_rows){
+        assert(chunk_rows_ > 0);
+        using Id = TaskGraph::TaskId;
+        const Id sort = graph_.add("sort", [this](std::size_t){ resort(world_, population_); }); //moves every row, so it goes first
+        const Id update = graph_.add("world", [this](std::size_t){
+            world_.update(dt_);
+            update_hunger(world_, population_);
+            perceive_begin(world_, population_.size(), population_.senses());
+        });
+        const Id sense = graph_.add("perceive", [this](std::size_t c){
+            perceive_rows(world_, population_.entities(), population_.board(), population_.senses(), first(c), last(c));
+        });
+        const Id neighbors = graph_.add("neighbors", [this](std::size_t){
+            if(flocking_enabled(world_.tuning)){ population_.neighbors().build(population_.entities()); }
+        });
+        const Id flock_task = graph_.add("flock", [this](std::size_t r){
+            if(flocking_enabled(world_.tuning)){ flock_rows(population_.neighbors(), world_.tuning, static_cast<int>(r), static_cast<int>(r) + 1); }
+        }, NeighborGrid::rows);
+        const Id tick = graph_.add("tick", [this](std::size_t c){
+            auto entities = population_.entities();
+            auto memory = population_.memory();
+            const bool flocking = flocking_enabled(world_.tuning);
+            for(std::size_t i = first(c); i < last(c); ++i){
+                Context ctx{entities[i], memory[i], world_, population_.board(), population_.senses(), i, &commands_[c]};
+                std::ignore = brain_.tick(ctx, dt_);
+                if(flocking){ flock(population_.neighbors(), entities[i], i); }
+            }
+        });
+        const Id integrate = graph_.add("integrate", [this](std::size_t c){
+            auto entities = population_.entities();
+            for(std::size_t i = first(c); i < last(c); ++i){ entities[i].update(dt_); }
+        });
+        const Id commands = graph_.add("commands", [this](std::size_t){
+            apply_commands(world_, population_, commands_);
+            if(snapshot_){
+                snapshot_->resize(population_.size());
+                snapshot_->capture_world(world_);
+            }
+        });
+        graph_.depends(update, sort, Wait::All);
+        graph_.depends(neighbors, sort, Wait::All);
+        graph_.depends(sense, update, Wait::All);
+        graph_.depends(tick, sense, Wait::Chunk);
+        graph_.depends(flock_task, neighbors, Wait::All);
+        graph_.depends(tick, flock_task, Wait::All);
+        graph_.depends(integrate, tick, Wait::Chunk);
+        graph_.depends(commands, integrate, Wait::All);
+        const Id capture = graph_.add("snapshot", [this](std::size_t c){
+            if(snapshot_){ snapshot_->capture_rows(population_, first(c), last(c)); }
+        });
+        graph_.depends(capture, commands, Wait::All);
+        chunked_ = {sense, tick, integrate, capture};
+    }
+
+    // One simulate() step, capturing the result into `snapshot` when given.
+    // Spawn and despawn between steps, never during one.
+    void step(JobSystem& jobs, float dt, RenderSnapshot* snapshot = nullptr){
+        dt_ = dt;
+        snapshot_ = snapshot;
+        const std::size_t chunks = std::max<std::size_t>(1, (population_.size() + chunk_rows_ - 1) / chunk_rows_);
+        for(const auto id : chunked_){ graph_.set_chunks(id, chunks); }
+        commands_.resize(chunks);
+        jobs.run(graph_);
+    }
+
+    const TaskGraph& graph() const noexcept{ return graph_; } //timings of the last step
+
+private:
+    World& world_;
+    const EntityBrain& brain_;
+    EntityPool& population_;
+    RenderSnapshot* snapshot_ = nullptr;
+    std::size_t chunk_rows_ = default_chunk_rows;
+    float dt_ = 0.0f;
+    std::vector<WorldCommands> commands_; //one per tick chunk, applied in chunk order
+    std::vector<TaskGraph::TaskId> chunked_;
+    TaskGraph graph_;
+
+    std::size_t first(std::size_t chunk) const noexcept{ return std::min(chunk * chunk_rows_, population_.size()); }
+    std::size_t last(std::size_t chunk) const noexcept{ return std::min((chunk + 1) * chunk_rows_, population_.size()); }
+};
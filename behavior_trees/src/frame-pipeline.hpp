@@ -0,0 +1,154 @@
+#pragma once
+#include "common.hpp"
+#include "entity-pool.hpp"
+#include "world.hpp"
+#include "keys.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+// Pipelined frames: the main thread draws frame N while a simulation thread computes N+1.
+//
+// The renderer never reads the World or the EntityPool. At the end of every simulation step
+// the simulation thread captures a RenderSnapshot: the World's drawable state and one compact
+// column per drawn attribute. There are two snapshots; the main thread draws the front one
+// while the simulation thread fills the back one, and they swap once both are done.
+//
+//   main thread:  input N+1 | draw N            | input N+2 | draw N+1 ...
+//   sim thread:             | simulate N+1 + capture         | simulate N+2 + capture ...
+//
+// Input is applied between the two, while the simulation thread is idle, so nothing is shared
+// while both threads run. The cost is one frame of latency: what is on screen is one step behind
+// the simulation. Frame time approaches max(simulate, draw) instead of their sum, given a second core.
+
+struct RenderSnapshot final{
+    WorldView world;
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> heading_x; //unit vector along the velocity
+    std::vector<float> heading_y;
+    std::vector<float> alpha;
+    std::vector<Activity> activity;
+    std::vector<std::int8_t> waypoint; //WaypointIndex, for the debug labels
+    std::uint32_t frame = 0;
+    float time = 0.0f;
+
+    std::size_t size() const noexcept{ return pos_x.size(); }
+
+    // Reuses the columns' capacity, so a steady population captures without allocating.
+    void capture(const World& w, const EntityPool& population){
+        resize(population.size());
+        capture_world(w);
+        capture_rows(population, 0, population.size());
+    }
+
+    // The split form of capture(), for callers that capture in chunks (frame-graph.hpp).
+    void resize(std::size_t n){
+        pos_x.resize(n);
+        pos_y.resize(n);
+        heading_x.resize(n);
+        heading_y.resize(n);
+        alpha.resize(n);
+        activity.resize(n);
+        waypoint.resize(n);
+    }
+
+    void capture_world(const World& w){
+        w.capture(world);
+        frame = w.frame;
+        time = w.time;
+    }
+
+    void capture_rows(const EntityPool& population, std::size_t first, std::size_t last) noexcept{
+        assert(last <= size() && population.size() == size());
+        const auto entities = population.entities();
+        for(std::size_t i = first; i < last; ++i){
+            const Entity& e = entities[i];
+            const Vector2 h = e.heading();
+            pos_x[i] = e.position.x;
+            pos_y[i] = e.position.y;
+            heading_x[i] = h.x;
+            heading_y[i] = h.y;
+            activity[i] = e.activity;
+        }
+        const auto& board = population.board();
+        if(board.has<Hunger>()){ //hungry agents fade out
+            for(std::size_t i = first; i < last; ++i){ alpha[i] = 1.0f - std::min(board.get<Hunger>(i).at(time), 1.0f) * 0.7f; }
+        } else{
+            std::fill(alpha.begin() + first, alpha.begin() + last, 1.0f);
+        }
+        if(board.has<WaypointIndex>()){
+            for(std::size_t i = first; i < last; ++i){ waypoint[i] = static_cast<std::int8_t>(board.get<WaypointIndex>(i)); }
+        } else{
+            std::fill(waypoint.begin() + first, waypoint.begin() + last, std::int8_t{0});
+        }
+    }
+};
+
+// One worker thread that runs one job at a time: kick() hands it a job, wait() blocks until
+// the job is done. Everything the job touches belongs to the worker between the two calls.
+// The job is kept in place (a lambda capturing a few references and values), so kicking one
+// every frame does not allocate, as a std::function with that many captures would.
+struct FrameWorker final{
+    static constexpr std::size_t job_bytes = 64;
+
+    FrameWorker() : thread_([this]{ run(); }){}
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+    ~FrameWorker(){
+        {
+            std::lock_guard lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    template <typename Fn>
+    void kick(Fn job){
+        static_assert(sizeof(Fn) <= job_bytes && alignof(Fn) <= alignof(std::max_align_t), "capture less, or capture a struct by reference");
+        static_assert(std::is_trivially_copyable_v<Fn>, "capture references and plain values only");
+        {
+            std::lock_guard lock(mutex_);
+            assert(!busy_ && "wait() for the previous job first");
+            ::new(static_cast<void*>(job_)) Fn(job);
+            run_job_ = [](void* fn){ (*static_cast<Fn*>(fn))(); };
+            busy_ = true;
+        }
+        wake_.notify_one();
+    }
+
+    void wait(){
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this]{ return !busy_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    alignas(std::max_align_t) std::byte job_[job_bytes];
+    void(*run_job_)(void* job) = nullptr;
+    bool busy_ = false;
+    bool quit_ = false;
+    std::thread thread_; //last: starts only once the members above exist
+
+    void run(){
+        for(;;){
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [this]{ return busy_ || quit_; });
+                if(!busy_) return;
+            }
+            run_job_(job_); //kick() does not touch the job until wait() has returned
+            {
+                std::lock_guard lock(mutex_);
+                busy_ = false;
+            }
+            done_.notify_one();
+        }
+    }
+};
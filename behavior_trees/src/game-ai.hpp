@@ -1,94 +1,348 @@
 #pragma once
 #include "behavior-tree.hpp"
 #include "steering.hpp"
+#include "coroutine-leaf.hpp"
+#include "keys.hpp"
+#include "entity-pool.hpp"
+#include <bit>
+
+// --- Senses ---
+// cached by the perception pass, unless the world changed under them earlier in this tick
+static Sense sensed_food(const Context& ctx) noexcept{
+    if(ctx.senses.food_serial == ctx.world.food_serial) return ctx.senses.food[ctx.index];
+    return sense(ctx.self.position, ctx.world.food_pos, ctx.world.food_field); //someone ate it this frame
+}
+
+static Sense sensed_waypoint(const Context& ctx, int waypoint) noexcept{
+    if(ctx.senses.waypoint_index[ctx.index] == waypoint) return ctx.senses.waypoint[ctx.index];
+    return sense(ctx.self.position, ctx.world.waypoints[waypoint], ctx.world.waypoint_fields[waypoint]); //advanced this frame
+}
+
+// --- World rules ---
+// Hunger is a LinearStat: nothing integrates it per frame. The moment it will cross
+// tuning.hunger_on is scheduled on the pool's timers, and only then is IsHungry raised, so
+// neither the integrator nor the tree looks at the hunger of an agent that is not hungry yet.
+constexpr std::uint32_t hunger_event = 0; //AgentEvent::kind
+
+static float hunger(const Blackboard& board, std::size_t row, float now) noexcept{
+    return std::min(board.get<Hunger>(row).at(now), 1.0f);
+}
+
+static void schedule_hunger(const World& world, EntityPool& pool, std::size_t row){
+    const float due = pool.board().get<Hunger>(row).when(world.tuning.hunger_on);
+    pool.timers().schedule(due, AgentEvent{pool.handle_at(row), hunger_event});
+}
+
+// Once per frame, before the tick: starts the hunger clock of agents spawned since the last
+// call, and raises IsHungry for everyone whose crossing is due. Trees without the keys skip it.
+static void update_hunger(World& world, EntityPool& pool){
+    auto& board = pool.board();
+    const auto spawned = pool.take_spawned();
+    if(!board.has<Hunger>() || !board.has<IsHungry>()) return;
+    for(const EntityHandle h : spawned){
+        if(!pool.alive(h)) continue;
+        const std::size_t row = pool.index_of(h);
+        LinearStat& stat = board.get<Hunger>(row);
+        stat.stamp = world.time;
+        stat.rate = Hunger::per_second;
+        schedule_hunger(world, pool, row);
+    }
+    pool.timers().pop_due(world.time, [&](const AgentEvent& e){
+        if(e.kind != hunger_event || !pool.alive(e.agent)) return;
+        const std::size_t row = pool.index_of(e.agent);
+        if(hunger(board, row, world.time) >= world.tuning.hunger_on){
+            board.set<IsHungry>(row, true, world.frame);
+        } else{
+            schedule_hunger(world, pool, row); //ate, or hunger_on was raised, since this was scheduled
+        }
+    });
+}
+
+// The agent at `row` eats the food: its hunger resets and the food moves elsewhere.
+static void eat_food(World& world, EntityPool& pool, std::size_t row){
+    auto& board = pool.board();
+    if(board.has<Hunger>()){
+        board.get<Hunger>(row).set(world.rng.range(0.0f, 0.12f), world.time);
+        schedule_hunger(world, pool, row);
+    }
+    if(board.has<IsHungry>()){ board.set<IsHungry>(row, false, world.frame); }
+    world.respawn_food();
+}
+
+// Applies the writes leaves deferred during the tick, and clears the buffers.
+// Only the first agent (lowest row) to reach the food eats it; the rest reached a food that is
+// already gone. Taking the lowest row rather than the first write keeps the result independent
+// of the order the agents were ticked in.
+static void apply_commands(World& world, EntityPool& pool, std::span<WorldCommands> buffers){
+    std::uint32_t first = WorldCommands::nobody;
+    for(const auto& b : buffers){ first = std::min(first, b.food_reached); }
+    if(first != WorldCommands::nobody){ eat_food(world, pool, first); }
+    for(auto& b : buffers){ b.clear(); }
+}
 
 // --- Leaf Functions ---
 // these are either conditions for the entity to check, or actions it needs to take
-static Status ThreatNearby(Context& ctx, float) noexcept{    
-    if(!ctx.world.wolf_active) return Status::Failure;
-    auto& entity = ctx.self;
-    const float dist = Vector2Distance(entity.position, ctx.world.wolf_pos);
-    return (dist < 180.0f) ? Status::Success : Status::Failure;
+constexpr Inputs threat_inputs = reads_self | reads_world(WorldInput::WolfPosition) | reads_world(WorldInput::WolfActive) | reads_key<ThreatSafeUntil>;
+
+// How long an agent `dist` from the wolf stays outside `radius` at least: the gap closes no faster
+// than both top speeds combined. Wrapping around the stage edge jumps the agent, so the bound
+// also ends when the agent could reach an edge. Shaved by a pixel against rounding.
+static float threat_safe_seconds(Vector2 pos, float dist, float radius) noexcept{
+    const float gap = (dist - radius - 1.0f) / (Entity::max_speed + World::wolf_max_speed);
+    const float edge = std::min({pos.x - ENTITY_SIZE, STAGE_WIDTH - pos.x, pos.y - ENTITY_SIZE, STAGE_HEIGHT - pos.y}) / Entity::max_speed;
+    return std::min(gap, edge);
 }
 
-static Status CheckHunger(Context& ctx, float) noexcept{
-    auto& entity = ctx.self;
-    if(!entity.isHungry && entity.hunger > 0.95f){
-        entity.isHungry = true;
+// An agent `dist` from the wolf and out of reach: record how long it stays that way.
+static void renew_threat_bound(const World& world, Blackboard& board, std::size_t row, Vector2 pos, float dist) noexcept{
+    const float safe = std::isinf(dist) ? dist : threat_safe_seconds(pos, dist, world.tuning.threat_radius);
+    if(safe > 0.0f){ board.set<ThreatSafeUntil>(row, {world.time + safe, world.threat_epoch}, world.frame); }
+}
+
+// Agents that are known to be out of reach fail without looking at the wolf (and the perception
+// pass skipped measuring them). Otherwise, when out of reach, work out for how long.
+static Status ThreatNearby(Context& ctx, float) noexcept{
+    const auto& world = ctx.world;
+    const bool bounded = ctx.board.has<ThreatSafeUntil>();
+    if(bounded && ctx.get<ThreatSafeUntil>().holds(world.time, world.threat_epoch)) return Status::Failure;
+    const float dist = ctx.senses.threat.dist[ctx.index]; //+infinity while the wolf is away
+    if(dist < world.tuning.threat_radius) return Status::Success;
+    if(bounded){ renew_threat_bound(world, ctx.board, ctx.index, ctx.self.position, dist); }
+    return Status::Failure;
+}
+
+static Status CheckHunger(Context& ctx, float) noexcept{ //IsHungry is raised by update_hunger() and cleared by eat_food()
+    return ctx.get<IsHungry>() ? Status::Success : Status::Failure;
+}
+
+// The two conditions for the whole population at once, as bitmasks (DecisionTable, decision-table.hpp).
+// Same results and same ThreatSafeUntil writes as the leaves.
+static void ThreatNearbyBatch(World& world, EntityPool& pool, std::span<std::uint64_t> out) noexcept{
+    using namespace simd;
+    static_assert(64 % width == 0);
+    const auto& dist = pool.senses().threat.dist;
+    const f32 radius = set1(world.tuning.threat_radius);
+    std::fill(out.begin(), out.end(), 0);
+    for_each_block(pool.size(), [&](std::size_t i, std::size_t n){
+        const std::uint64_t near = bits(less(load_n(&dist[i], n, std::numeric_limits<float>::infinity()), radius));
+        out[i / 64] |= near << (i % 64);
+    });
+    auto& board = pool.board();
+    if(!board.has<ThreatSafeUntil>()) return;
+    const auto bounds = board.column<ThreatSafeUntil>();
+    const auto entities = pool.entities();
+    for(std::size_t w = 0; w < out.size(); ++w){ //64 agents at a time: mask off the safe ones, renew the bounds of the rest that are out of reach
+        const std::size_t first = w * 64, n = std::min<std::size_t>(64, pool.size() - first);
+        std::uint64_t safe = 0;
+        for(std::size_t k = 0; k < n; ++k){ safe |= std::uint64_t{bounds[first + k].holds(world.time, world.threat_epoch)} << k; }
+        const std::uint64_t valid = (n == 64) ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1;
+        out[w] &= ~safe;
+        for(std::uint64_t renew = valid & ~safe & ~out[w]; renew != 0; renew &= renew - 1){
+            const std::size_t i = first + static_cast<std::size_t>(std::countr_zero(renew));
+            renew_threat_bound(world, board, i, entities[i].position, dist[i]);
+        }
     }
-    if(entity.isHungry && entity.hunger < 0.05f){
-        entity.isHungry = false;
+}
+
+static void CheckHungerBatch(World&, EntityPool& pool, std::span<std::uint64_t> out) noexcept{
+    const auto hungry = pool.board().column<IsHungry>();
+    for(std::size_t w = 0; w < out.size(); ++w){
+        const std::size_t first = w * 64, last = std::min(first + 64, hungry.size());
+        std::uint64_t word = 0;
+        for(std::size_t i = first; i < last; ++i){ word |= std::uint64_t{hungry[i]} << (i - first); }
+        out[w] = word;
     }
-    return entity.isHungry ? Status::Success : Status::Failure;
 }
 
 static Status DoFlee(Context& ctx, float) noexcept{
     auto& entity = ctx.self;
-    entity.debug_state = "FLEE";
-    entity.acceleration += steer_flee(entity, ctx.world.wolf_pos, Entity::max_speed);
+    entity.activity = Activity::Flee;
+    Vector2 away = Vector2Negate(ctx.senses.threat[ctx.index].dir);
+    if(Vector2LengthSqr(away) == 0.0f) away = Vector2{1, 0}; //standing on the wolf
+    entity.acceleration += steer_along(entity, away, Entity::max_speed, ctx.world.tuning.flee_weight);
     entity.acceleration += steer_drag(entity);
     return Status::Running;
 }
 
 static Status MoveToCorner(Context& ctx, float) noexcept{
     auto& entity = ctx.self;
-    entity.debug_state = "PATROL";
-    const Vector2 target = ctx.world.waypoints[entity.waypoint_index];
-    const float dist = Vector2Distance(entity.position, target);
+    entity.activity = Activity::Patrol;
+    const Sense waypoint = sensed_waypoint(ctx, ctx.get<WaypointIndex>());
 
     entity.acceleration = ZERO;
-    entity.acceleration += steer_seek(entity, target, Entity::max_speed * 0.65f);
+    entity.acceleration += steer_along(entity, waypoint.dir, Entity::max_speed * ctx.world.tuning.patrol_speed, Entity::seek_weight);
     entity.acceleration += steer_drag(entity);
 
-    if(dist <= World::waypoint_radius){
+    if(waypoint.dist <= World::waypoint_radius){
         return Status::Success;
     }
     return Status::Running;
 }
 
 static Status AdvanceCorner(Context& ctx, float) noexcept{
-    auto& entity = ctx.self;
     const auto count = (int) ctx.world.waypoints.size();
-    entity.waypoint_index = (entity.waypoint_index + 1) % count;
+    ctx.set<WaypointIndex>((ctx.get<WaypointIndex>() + 1) % count);
     return Status::Success;
 }
 
 static Status DoSeekFood(Context& ctx, float) noexcept{
     auto& entity = ctx.self;
-    entity.debug_state = "SEEK FOOD";
+    entity.activity = Activity::SeekFood;
+    const Sense food = sensed_food(ctx);
     entity.acceleration = ZERO;
-    entity.acceleration += steer_seek(entity, ctx.world.food_pos, Entity::max_speed * 0.7f);
+    entity.acceleration += steer_along(entity, food.dir, Entity::max_speed * ctx.world.tuning.seek_speed, Entity::seek_weight);
     entity.acceleration += steer_drag(entity);
-    const float dist = Vector2Distance(entity.position, ctx.world.food_pos);
-    if(dist < World::food_radius){
-        entity.hunger = random_range(0.0f, 0.12f);
-        entity.isHungry = false;
-        ctx.world.respawn_food();
+    if(food.dist < World::food_radius){
+        assert(ctx.commands && "DoSeekFood eats through ctx.commands; tick it with a WorldCommands buffer");
+        ctx.commands->reach_food(ctx.index); //the lowest row that reached the food eats, once the tick is over
         return Status::Success;
     }
     return Status::Running;
 }
 
+// --- Batch forms ---
+// The same leaves over a span of rows (Leaf::batch, ticked by BatchTree in batch-tree.hpp): one
+// call per node and frame instead of one per agent, with everything that is the same for every
+// agent looked up once. Statuses and writes are those of the scalar leaves, row for row.
+// AdvanceCorner has none and is ticked per row.
+static void ThreatNearbyRows(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float) noexcept{
+    const auto& world = ctx.world;
+    const auto& dist = ctx.senses.threat.dist;
+    const float radius = world.tuning.threat_radius;
+    if(!ctx.board.has<ThreatSafeUntil>()){
+        for(std::size_t j = 0; j < rows.size(); ++j){ out[j] = dist[rows[j]] < radius ? Status::Success : Status::Failure; }
+        return;
+    }
+    const auto bounds = ctx.board.column<ThreatSafeUntil>();
+    for(std::size_t j = 0; j < rows.size(); ++j){
+        const std::uint32_t i = rows[j];
+        out[j] = Status::Failure;
+        if(bounds[i].holds(world.time, world.threat_epoch)) continue;
+        if(dist[i] < radius){
+            out[j] = Status::Success;
+            continue;
+        }
+        renew_threat_bound(world, ctx.board, i, ctx.entities[i].position, dist[i]);
+    }
+}
+
+static void CheckHungerRows(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float) noexcept{
+    const auto hungry = ctx.board.column<IsHungry>();
+    for(std::size_t j = 0; j < rows.size(); ++j){ out[j] = hungry[rows[j]] ? Status::Success : Status::Failure; }
+}
+
+static void DoFleeRows(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float) noexcept{
+    const auto& threat = ctx.senses.threat;
+    const float weight = ctx.world.tuning.flee_weight;
+    for(std::size_t j = 0; j < rows.size(); ++j){
+        const std::uint32_t i = rows[j];
+        auto& entity = ctx.entities[i];
+        entity.activity = Activity::Flee;
+        Vector2 away = Vector2{-threat.dir_x[i], -threat.dir_y[i]};
+        if(Vector2LengthSqr(away) == 0.0f) away = Vector2{1, 0};
+        entity.acceleration += steer_along(entity, away, Entity::max_speed, weight);
+        entity.acceleration += steer_drag(entity);
+        out[j] = Status::Running;
+    }
+}
+
+static void MoveToCornerRows(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float) noexcept{
+    const auto& world = ctx.world;
+    const auto& senses = ctx.senses;
+    const auto corner = ctx.board.column<WaypointIndex>();
+    const float speed = Entity::max_speed * world.tuning.patrol_speed;
+    for(std::size_t j = 0; j < rows.size(); ++j){
+        const std::uint32_t i = rows[j];
+        auto& entity = ctx.entities[i];
+        entity.activity = Activity::Patrol;
+        const int w = corner[i];
+        const Sense waypoint = (senses.waypoint_index[i] == w) ? senses.waypoint[i] : sense(entity.position, world.waypoints[w], world.waypoint_fields[w]);
+        entity.acceleration = ZERO;
+        entity.acceleration += steer_along(entity, waypoint.dir, speed, Entity::seek_weight);
+        entity.acceleration += steer_drag(entity);
+        out[j] = (waypoint.dist <= World::waypoint_radius) ? Status::Success : Status::Running;
+    }
+}
+
+static void DoSeekFoodRows(BatchContext& ctx, std::span<const std::uint32_t> rows, std::span<Status> out, float) noexcept{
+    const auto& world = ctx.world;
+    const auto& senses = ctx.senses;
+    const bool fresh = senses.food_serial == world.food_serial; //leaves only defer eating, so this holds for the whole call
+    const float speed = Entity::max_speed * world.tuning.seek_speed;
+    assert(ctx.commands && "DoSeekFoodRows eats through ctx.commands; tick it with a WorldCommands buffer");
+    for(std::size_t j = 0; j < rows.size(); ++j){
+        const std::uint32_t i = rows[j];
+        auto& entity = ctx.entities[i];
+        entity.activity = Activity::SeekFood;
+        const Sense food = fresh ? senses.food[i] : sense(entity.position, world.food_pos, world.food_field);
+        entity.acceleration = ZERO;
+        entity.acceleration += steer_along(entity, food.dir, speed, Entity::seek_weight);
+        entity.acceleration += steer_drag(entity);
+        out[j] = Status::Running;
+        if(food.dist < World::food_radius){
+            ctx.commands->reach_food(i);
+            out[j] = Status::Success;
+        }
+    }
+}
+
 //let's assemble a behavior tree :D 
 
 struct DemoTree final{
+    using Keys = KeySet<WaypointIndex, IsHungry, Hunger, ThreatSafeUntil>;
+
     // threat branch
-    Leaf threat{ThreatNearby};
-    Leaf flee{DoFlee};
+    Leaf threat{ThreatNearby, condition_writing("ThreatNearby", threat_inputs, reads_key<ThreatSafeUntil>), ThreatNearbyRows};
+    Leaf flee{DoFlee, action("DoFlee", outcome(Status::Running)), DoFleeRows};
     Sequence fleeSeq{&threat, &flee};
 
     // patrol branch
-    Leaf moveToCorner{MoveToCorner};
-    Leaf advanceCorner{AdvanceCorner};
+    Leaf moveToCorner{MoveToCorner, action("MoveToCorner", outcome(Status::Success) | outcome(Status::Running)), MoveToCornerRows};
+    Leaf advanceCorner{AdvanceCorner, action("AdvanceCorner", outcome(Status::Success))};
     MemorySequence patrolSeq{0, {&moveToCorner, &advanceCorner}};
     RepeatForever patrolLoop{&patrolSeq};
 
     // hunger branch
-    Leaf hungry{CheckHunger};
-    Leaf seekFood{DoSeekFood};
+    Leaf hungry{CheckHunger, condition("CheckHunger", reads_key<IsHungry>), CheckHungerRows};
+    Leaf seekFood{DoSeekFood, action("DoSeekFood", outcome(Status::Success) | outcome(Status::Running)), DoSeekFoodRows};
     Sequence foodSeq{&hungry, &seekFood};
 
     //this brain can: avoid threats, patrol waypoints, and find food when hungry.
     Selector root{&fleeSeq, &foodSeq, &patrolLoop};
     EntityBrain brain{&root};
+};
+
+// The patrol branch again, as a coroutine: the loop over the waypoints is ordinary
+// control flow instead of MemorySequence + RepeatForever. Progress (the waypoint) still
+// lives on the blackboard, so a patrol preempted by the wolf resumes at the same corner.
+static Action PatrolRoute(Tick& t){
+    for(;;){
+        while(MoveToCorner(t.context(), t.dt) == Status::Running){
+            co_await t.next_tick();
+        }
+        std::ignore = AdvanceCorner(t.context(), t.dt);
+    }
+}
+
+// Same brain as DemoTree, with the patrol branch running as a pooled coroutine.
+// The arena must hold one frame per agent that can be patrolling at the same time;
+// call arena.reap(world.frame) once per frame, after the tick.
+struct CoroutineDemoTree final{
+    using Keys = DemoTree::Keys;
+    CoroutineArena arena;
+
+    Leaf threat{ThreatNearby, condition_writing("ThreatNearby", threat_inputs, reads_key<ThreatSafeUntil>)};
+    Leaf flee{DoFlee, action("DoFlee", outcome(Status::Running))};
+    Sequence fleeSeq{&threat, &flee};
+
+    Leaf hungry{CheckHunger, condition("CheckHunger", reads_key<IsHungry>)};
+    Leaf seekFood{DoSeekFood, action("DoSeekFood", outcome(Status::Success) | outcome(Status::Running))};
+    Sequence foodSeq{&hungry, &seekFood};
+
+    CoroutineLeaf patrol{1, PatrolRoute, arena};
+
+    Selector root{&fleeSeq, &foodSeq, &patrol};
+    EntityBrain brain{&root};
+
+    explicit CoroutineDemoTree(std::size_t max_agents) : arena(max_agents){}
 };
\ No newline at end of file
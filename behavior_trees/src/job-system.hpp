@@ -0,0 +1,334 @@
+#pragma once
+#include "common.hpp"
+#include "frame-arena.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// A small job system for the per-frame stages.
+//
+// A TaskGraph is a list of tasks. Each task is split into chunks (a parallel-for) and may wait
+// on earlier tasks in one of two ways:
+//   Wait::All   - every chunk of the earlier task must be done (a barrier between two stages)
+//   Wait::Chunk - only the chunk with the same index (the chunks flow through both stages)
+// A JobSystem runs a graph on its worker threads plus the calling thread and returns when every
+// chunk has run. The graph is kept between runs; only the chunk counts change with the population.
+//
+// Every chunk is timed, so after a run the graph can print its critical path (the chain of chunks
+// that bounded the frame) and a per-thread timeline.
+//
+//   TaskGraph g;
+//   const auto world = g.add("world", [&](std::size_t){ world.update(dt); });
+//   const auto tick  = g.add("tick", [&](std::size_t chunk){ ...rows of `chunk`... });
+//   g.depends(tick, world, Wait::All);
+//   g.set_chunks(tick, 16);
+//   jobs.run(g);
+
+enum class Wait : std::uint8_t{ All, Chunk };
+
+struct TaskGraph final{
+    using TaskId = std::uint32_t;
+    using Fn = std::function<void(std::size_t chunk)>;
+
+    struct Span final{            //one chunk of one task, as it ran
+        TaskId task = 0;
+        std::uint32_t chunk = 0;
+        std::uint32_t thread = 0;  //0 is the thread that called JobSystem::run
+        double start_ns = 0.0;     //since the start of the run
+        double end_ns = 0.0;
+    };
+
+    TaskId add(std::string name, Fn fn, std::size_t chunks = 1){
+        assert(chunks > 0);
+        tasks_.push_back(Task{std::move(name), std::move(fn), static_cast<std::uint32_t>(chunks), {}});
+        return static_cast<TaskId>(tasks_.size() - 1);
+    }
+
+    // `task` waits for `on`, which must have been added before it.
+    void depends(TaskId task, TaskId on, Wait wait = Wait::All){
+        assert(on < task && task < tasks_.size());
+        tasks_[task].deps.push_back({on, wait});
+    }
+
+    void set_chunks(TaskId task, std::size_t chunks) noexcept{
+        assert(chunks > 0 && "give an empty stage one empty chunk");
+        tasks_[task].chunks = static_cast<std::uint32_t>(chunks);
+    }
+    std::size_t chunks(TaskId task) const noexcept{ return tasks_[task].chunks; }
+    std::size_t size() const noexcept{ return tasks_.size(); }
+    const std::string& name(TaskId task) const noexcept{ return tasks_[task].name; }
+
+    // --- results of the last run ---
+    std::span<const Span> spans() const noexcept{ return spans_; }
+    double wall_ns() const noexcept{ return wall_ns_; }
+
+    // The longest chain of chunks through the dependencies, weighted by how long each chunk took.
+    // No schedule can finish the frame faster than this on any number of threads.
+    std::vector<Span> critical_path() const{
+        std::vector<double> length(spans_.size(), 0.0);
+        std::vector<std::size_t> previous(spans_.size(), none);
+        std::vector<std::size_t> longest(tasks_.size(), none); //per task: its chunk with the longest path
+        for(TaskId t = 0; t < tasks_.size(); ++t){
+            const Task& task = tasks_[t];
+            for(std::uint32_t c = 0; c < task.chunks; ++c){
+                const std::size_t item = first_[t] + c;
+                std::size_t best = none;
+                for(const Dep& d : task.deps){
+                    const std::size_t p = (d.wait == Wait::Chunk) ? first_[d.task] + c : longest[d.task];
+                    if(p != none && (best == none || length[p] > length[best])) best = p;
+                }
+                length[item] = (spans_[item].end_ns - spans_[item].start_ns) + (best != none ? length[best] : 0.0);
+                previous[item] = best;
+                if(longest[t] == none || length[item] > length[longest[t]]) longest[t] = item;
+            }
+        }
+        std::size_t end = none;
+        for(std::size_t i = 0; i < spans_.size(); ++i){
+            if(end == none || length[i] > length[end]) end = i;
+        }
+        std::vector<Span> path;
+        for(std::size_t i = end; i != none; i = previous[i]){ path.push_back(spans_[i]); }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    void print_critical_path(std::FILE* out) const{
+        const auto path = critical_path();
+        double total = 0.0;
+        for(const Span& s : path){ total += s.end_ns - s.start_ns; }
+        std::fprintf(out, "critical path %.1f us of %.1f us wall (%zu chunks on %u threads)\n",
+            total / 1000.0, wall_ns_ / 1000.0, spans_.size(), threads_);
+        for(const Span& s : path){
+            std::fprintf(out, "  %-12s chunk %3u  %8.1f us  on thread %u\n", tasks_[s.task].name.c_str(), s.chunk,
+                (s.end_ns - s.start_ns) / 1000.0, s.thread);
+        }
+    }
+
+    // One row per thread, one column per wall / width of the run; each cell shows the task
+    // that ran longest in it (A = first task, B = second, ...), '.' when the thread was idle.
+    void print_timeline(std::FILE* out, std::size_t width = 100) const{
+        if(wall_ns_ <= 0.0) return;
+        const double cell_ns = wall_ns_ / static_cast<double>(width);
+        for(std::uint32_t thread = 0; thread < threads_; ++thread){
+            std::string row(width, '.');
+            std::vector<double> best(width, 0.0);
+            for(const Span& s : spans_){
+                if(s.thread != thread) continue;
+                const auto first = static_cast<std::size_t>(s.start_ns / cell_ns);
+                const auto last = std::min(width - 1, static_cast<std::size_t>(s.end_ns / cell_ns));
+                for(std::size_t x = first; x <= last; ++x){
+                    const double covered = std::min(s.end_ns, static_cast<double>(x + 1) * cell_ns) - std::max(s.start_ns, static_cast<double>(x) * cell_ns);
+                    if(covered > best[x]){
+                        best[x] = covered;
+                        row[x] = static_cast<char>('A' + s.task % 26);
+                    }
+                }
+            }
+            std::fprintf(out, "  thread %2u |%s|\n", thread, row.c_str());
+        }
+        for(TaskId t = 0; t < tasks_.size(); ++t){
+            std::fprintf(out, "  %c=%s", static_cast<char>('A' + t % 26), tasks_[t].name.c_str());
+        }
+        std::fprintf(out, "\n");
+    }
+
+private:
+    friend struct JobSystem;
+    static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    struct Dep final{
+        TaskId task;
+        Wait wait;
+    };
+    struct Task final{
+        std::string name;
+        Fn fn;
+        std::uint32_t chunks = 1;
+        std::vector<Dep> deps;
+    };
+
+    std::vector<Task> tasks_;
+    // per run, indexed by first_[task] + chunk. The counters are only touched under the
+    // JobSystem's lock; each span only by the thread running that chunk.
+    std::vector<std::size_t> first_;
+    std::vector<Span> spans_;
+    std::vector<std::uint32_t> waiting_;   //dependencies each chunk still waits on
+    std::vector<std::uint32_t> remaining_; //per task: chunks not finished yet
+    std::vector<std::vector<TaskId>> dependents_;
+    double wall_ns_ = 0.0;
+    std::uint32_t threads_ = 1;
+
+    void prepare(){
+        first_.resize(tasks_.size() + 1);
+        first_[0] = 0;
+        for(TaskId t = 0; t < tasks_.size(); ++t){ first_[t + 1] = first_[t] + tasks_[t].chunks; }
+        const std::size_t items = first_.back();
+        spans_.assign(items, Span{});
+        waiting_.resize(items);
+        remaining_.resize(tasks_.size());
+        dependents_.assign(tasks_.size(), {});
+        for(TaskId t = 0; t < tasks_.size(); ++t){
+            const Task& task = tasks_[t];
+            remaining_[t] = task.chunks;
+            for(const Dep& d : task.deps){
+                assert((d.wait == Wait::All || tasks_[d.task].chunks == task.chunks) && "Wait::Chunk needs equal chunk counts");
+                dependents_[d.task].push_back(t);
+            }
+            for(std::uint32_t c = 0; c < task.chunks; ++c){
+                waiting_[first_[t] + c] = static_cast<std::uint32_t>(task.deps.size());
+            }
+        }
+    }
+};
+
+struct JobSystem final{
+    // `threads` counts the calling thread too: JobSystem{1} runs everything inline.
+    explicit JobSystem(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())){
+        for(std::size_t i = 1; i < threads; ++i){
+            workers_.emplace_back([this, i]{ work(static_cast<std::uint32_t>(i)); });
+        }
+    }
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem(){
+        {
+            std::lock_guard lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for(auto& w : workers_){ w.join(); }
+    }
+
+    std::size_t thread_count() const noexcept{ return workers_.size() + 1; }
+
+    // Runs every chunk of every task, respecting the dependencies. Blocks until done.
+    // Each thread rewinds its frame arena (frame-arena.hpp) as it joins the run, the calling
+    // thread's included: tasks get fresh frame memory, and must not keep it past the run.
+    // Which thread runs a chunk changes from run to run, so each arena is also grown to the
+    // largest any thread has needed; otherwise a thread would call operator new the first time
+    // it happened to pick up a big chunk (the Morton re-sort, say), however long the warm-up.
+    void run(TaskGraph& graph){
+        graph.prepare();
+        graph.threads_ = static_cast<std::uint32_t>(thread_count());
+        {
+            std::lock_guard lock(mutex_);
+            frame_arena().reset();
+            frame_arena().reserve(arena_bytes_);
+            ready_.reserve(graph.spans_.size()); //every chunk may be ready at once
+            start_ = clock::now();
+            graph_ = &graph;
+            ++runs_;
+            left_ = graph.spans_.size();
+            for(TaskGraph::TaskId t = 0; t < graph.tasks_.size(); ++t){
+                if(!graph.tasks_[t].deps.empty()) continue;
+                for(std::uint32_t c = 0; c < graph.tasks_[t].chunks; ++c){ ready_.push_back({t, c}); }
+            }
+        }
+        wake_.notify_all();
+        help(0);
+        graph.wall_ns_ = elapsed_ns();
+        std::lock_guard lock(mutex_);
+        graph_ = nullptr;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+    struct Item final{
+        TaskGraph::TaskId task;
+        std::uint32_t chunk;
+    };
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::vector<Item> ready_;
+    TaskGraph* graph_ = nullptr;
+    std::size_t left_ = 0; //chunks of the current run not finished yet
+    std::size_t arena_bytes_ = 0; //largest frame arena of any thread after a run
+    std::uint64_t runs_ = 0;
+    bool quit_ = false;
+    clock::time_point start_;
+
+    double elapsed_ns() const noexcept{
+        return std::chrono::duration<double, std::nano>(clock::now() - start_).count();
+    }
+
+    void work(std::uint32_t thread){
+        std::uint64_t joined = 0;
+        for(;;){
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this]{ return quit_ || !ready_.empty(); });
+            if(quit_) return;
+            if(std::exchange(joined, runs_) != runs_){
+                frame_arena().reset();
+                frame_arena().reserve(arena_bytes_);
+            }
+            lock.unlock();
+            help(thread);
+        }
+    }
+
+    // Runs ready chunks until the queue is empty; the calling thread stays until the whole graph is done.
+    void help(std::uint32_t thread){
+        std::unique_lock lock(mutex_);
+        for(;;){
+            if(ready_.empty()){
+                if(thread != 0 || left_ == 0){
+                    arena_bytes_ = std::max(arena_bytes_, frame_arena().capacity());
+                    return;
+                }
+                idle_.wait(lock, [this]{ return left_ == 0 || !ready_.empty(); });
+                continue;
+            }
+            const Item item = ready_.back();
+            ready_.pop_back();
+            TaskGraph& g = *graph_;
+            lock.unlock();
+
+            auto& span = g.spans_[g.first_[item.task] + item.chunk];
+            span = {item.task, item.chunk, thread, elapsed_ns(), 0.0};
+            g.tasks_[item.task].fn(item.chunk);
+            span.end_ns = elapsed_ns();
+
+            lock.lock();
+            complete(g, item);
+        }
+    }
+
+    // Called with the lock held.
+    void complete(TaskGraph& g, Item item){
+        const std::size_t before = ready_.size();
+        for(const TaskGraph::TaskId d : g.dependents_[item.task]){
+            for(const auto& dep : g.tasks_[d].deps){
+                if(dep.task == item.task && dep.wait == Wait::Chunk) release(g, d, item.chunk);
+            }
+        }
+        if(--g.remaining_[item.task] == 0){
+            finish_task(g, item.task);
+        }
+        --left_;
+        if(ready_.size() > before + 1){ wake_.notify_all(); } else if(ready_.size() > before){ wake_.notify_one(); }
+        if(left_ == 0 || ready_.size() > before){ idle_.notify_one(); }
+    }
+
+    void finish_task(TaskGraph& g, TaskGraph::TaskId task){
+        for(const TaskGraph::TaskId d : g.dependents_[task]){
+            for(const auto& dep : g.tasks_[d].deps){
+                if(dep.task != task || dep.wait != Wait::All) continue;
+                for(std::uint32_t c = 0; c < g.tasks_[d].chunks; ++c){ release(g, d, c); }
+            }
+        }
+    }
+
+    void release(TaskGraph& g, TaskGraph::TaskId task, std::uint32_t chunk){
+        if(--g.waiting_[g.first_[task] + chunk] == 0){
+            ready_.push_back({task, chunk});
+        }
+    }
+};
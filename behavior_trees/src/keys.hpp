@@ -0,0 +1,40 @@
+#pragma once
+#include "blackboard.hpp"
+#include "linear-stat.hpp"
+
+// Blackboard keys of the demo's trees.
+// Per-entity state shared between leaves (and read by the perception pass);
+// only the keys a tree lists in its KeySet are allocated.
+enum KeyId : std::size_t{ WaypointIndexKey, IsHungryKey, HungerKey, ThreatSafeUntilKey, ActiveBranchKey,
+    SquadOfKey, SquadDirectiveKey, SquadFormationKey, //the squad keys are defined with the squads (squad.hpp)
+    DistantKey };
+
+struct WaypointIndex final : BlackboardKey<int, WaypointIndexKey>{ // patrol mission
+    static int initial(Rng& rng) noexcept{ return rng.range(0, 3); }
+};
+struct IsHungry final : BlackboardKey<bool, IsHungryKey>{}; // hunger mission
+
+// 0 = fed, 1 = starving. Read it with hunger() (game-ai.hpp), which clamps.
+// Spawned agents hold their initial value until update_hunger() adopts them and starts the drift.
+struct Hunger final : BlackboardKey<LinearStat, HungerKey>{
+    static constexpr float per_second = 0.04f;
+    static LinearStat initial(Rng& rng) noexcept{ return {rng.range(0.0f, 1.0f), 0.0f, 0.0f}; }
+};
+
+// Until `time`, the agent provably cannot be within the threat radius (ThreatNearby in game-ai.hpp
+// derives it from the speed limits of agent and wolf). Only valid while the world's threat_epoch
+// is still `epoch`: toggling or moving the wolf by hand bumps it. The default has expired.
+struct SafeUntil final{
+    float time = 0.0f;
+    std::uint32_t epoch = 0;
+
+    bool holds(float now, std::uint32_t threat_epoch) const noexcept{ return now < time && epoch == threat_epoch; }
+};
+struct ThreatSafeUntil final : BlackboardKey<SafeUntil, ThreatSafeUntilKey>{};
+
+// Which child of the root Selector the agent ended up in on its last tick; the number of
+// children if they all failed. Kept by BucketedBrain (bucketed-brain.hpp) to group agents.
+struct ActiveBranch final : BlackboardKey<std::uint8_t, ActiveBranchKey>{};
+
+// Away from everything that matters: moved by FarField's coarse model instead of the tree (far-field.hpp).
+struct Distant final : BlackboardKey<bool, DistantKey>{};
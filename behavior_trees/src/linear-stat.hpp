@@ -0,0 +1,59 @@
+#pragma once
+#include "common.hpp"
+
+// Stats that drift at a constant rate (hunger, fatigue, cooldowns, ...), stored as
+// value + rate + timestamp and evaluated when read, instead of being integrated every frame.
+// Since the value is a straight line, the moment it crosses a threshold is known in advance:
+// schedule that moment in a TimerQueue and nothing has to look at the stat until then.
+struct LinearStat final{
+    float value = 0.0f;  //at `stamp`
+    float rate = 0.0f;   //per second
+    float stamp = 0.0f;  //world time of the last set()
+
+    float at(float now) const noexcept{ return value + rate * (now - stamp); }
+
+    void set(float v, float now) noexcept{
+        value = v;
+        stamp = now;
+    }
+
+    // World time at which at() reaches `threshold`; +infinity if it never does.
+    float when(float threshold) const noexcept{
+        if(value >= threshold) return stamp;
+        if(rate <= 0.0f) return std::numeric_limits<float>::infinity();
+        return stamp + (threshold - value) / rate;
+    }
+};
+
+// Min-heap of (due time, payload). pop_due() hands out everything due by `now`, earliest first.
+template <typename T>
+struct TimerQueue final{
+    struct Timer final{
+        float due;
+        T payload;
+        bool operator>(const Timer& other) const noexcept{ return due > other.due; }
+    };
+
+    void schedule(float due, const T& payload){
+        if(!std::isfinite(due)) return; //never
+        heap_.push_back({due, payload});
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<>{});
+    }
+
+    template <typename Fn>
+    void pop_due(float now, Fn&& fn){
+        while(!heap_.empty() && heap_.front().due <= now){
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<>{});
+            const Timer t = heap_.back();
+            heap_.pop_back();
+            fn(t.payload);
+        }
+    }
+
+    std::size_t size() const noexcept{ return heap_.size(); }
+    float next_due() const noexcept{ return heap_.empty() ? std::numeric_limits<float>::infinity() : heap_.front().due; }
+    void clear() noexcept{ heap_.clear(); }
+
+private:
+    std::vector<Timer> heap_;
+};
@@ -9,35 +9,49 @@
 #include "common.hpp"
 #include "window.hpp"
 #include "entity.hpp"
+#include "entity-pool.hpp"
 #include "world.hpp"
 #include "steering.hpp"
 #include "behavior-tree.hpp"
 #include "game-ai.hpp"
+#include "simulation.hpp"
+#include "frame-pipeline.hpp"
+#include "frame-graph.hpp"
+#include <thread>
 
-static void update(World& world, const DemoTree& tree, std::span<Entity> entities, float dt) noexcept{
-	world.update(dt);
-	for(auto& e : entities){
-		Context ctx{e, world};
-		std::ignore = tree.brain.tick(ctx, dt);
-		e.update(dt);
-	}
+// Draws an agent from plain values, so a render snapshot (frame-pipeline.hpp) can draw without an Entity.
+static void draw_agent(Vector2 position, Vector2 heading, float alpha) noexcept{
+	Vector2 local_x = heading;
+	Vector2 local_y = {-local_x.y, local_x.x};
+	float L = ENTITY_SIZE;
+	float H = ENTITY_SIZE;
+	Vector2 tip = position + (local_x * L * 1.4f);
+	Vector2 left = position - (local_x * L) + (local_y * H);
+	Vector2 right = position - (local_x * L) - (local_y * H);
+	DrawTriangle(tip, right, left, Fade(GREEN, alpha));
 }
 
-static void render(const World& world, std::span<const Entity> entities) noexcept{
+static void render(const RenderSnapshot& frame) noexcept{
+	constexpr std::size_t max_labels = 8; //per-agent debug text is unreadable beyond a handful of agents
+	const std::size_t count = frame.size();
 	BeginDrawing();
 	ClearBackground(CLEAR_COLOR);
-	world.render();
-	for(const auto& e : entities){
-		e.render();
-		Vector2 p = {e.position.x + 10.0f, e.position.y + 10.0f};
-		DrawText(TextFormat("Mode: %s", e.debug_state.data()), p.x, p.y, FONT_SIZE, DARKGRAY);
-		if(e.debug_state == "SEEK FOOD"){
-			DrawLineV(e.position, world.food_pos, Fade(DARKGREEN, 0.5f));
-		} else if(e.debug_state == "PATROL"){
-			DrawText(TextFormat("WP: %d", e.waypoint_index), p.x, p.y + FONT_SIZE, FONT_SIZE, DARKGRAY);
-			DrawLineV(e.position, world.waypoints[e.waypoint_index], Fade(DARKGREEN, 0.5f));
+	frame.world.render();
+	for(std::size_t i = 0; i < count; ++i){
+		const Vector2 pos = {frame.pos_x[i], frame.pos_y[i]};
+		draw_agent(pos, {frame.heading_x[i], frame.heading_y[i]}, frame.alpha[i]);
+		if(count > max_labels) continue;
+		Vector2 p = {pos.x + 10.0f, pos.y + 10.0f};
+		DrawText(TextFormat("Mode: %s", to_string(frame.activity[i])), p.x, p.y, FONT_SIZE, DARKGRAY);
+		if(frame.activity[i] == Activity::SeekFood){
+			DrawLineV(pos, frame.world.food_pos, Fade(DARKGREEN, 0.5f));
+		} else if(frame.activity[i] == Activity::Patrol){
+			const int wp = frame.waypoint[i];
+			DrawText(TextFormat("WP: %d", wp), p.x, p.y + FONT_SIZE, FONT_SIZE, DARKGRAY);
+			DrawLineV(pos, frame.world.waypoints[wp], Fade(DARKGREEN, 0.5f));
 		}
 	}
+	DrawText(TextFormat("Agents: %d (+/- to add/remove)", static_cast<int>(count)), 10, STAGE_HEIGHT - FONT_SIZE * 3, FONT_SIZE, DARKGRAY);
 	DrawText("Press SPACE to pause/unpause", 10, STAGE_HEIGHT - FONT_SIZE, FONT_SIZE, DARKGRAY);
 	DrawFPS(10, STAGE_HEIGHT - FONT_SIZE * 2);
 	EndDrawing();
@@ -46,21 +60,51 @@ static void render(const World& world, std::span<const Entity> entities) noexcep
 int main(){
 	auto window = Window(STAGE_WIDTH, STAGE_HEIGHT, "Behavior Tree Demo");
 	bool isPaused = false;
-	std::vector<Entity> entities(1);
+	constexpr std::size_t spawn_batch = 100;
+	Rng rng{static_cast<std::uint64_t>(GetRandomValue(0, std::numeric_limits<int>::max()))};
+	EntityPool population{Blackboard{DemoTree::Keys{}}};
+	population.spawn(1, rng);
 	World world;
+	world.rng = Rng{rng.next()};
 	DemoTree tree;
+	//the simulation thread owns world and population between kick() and wait(); the main thread only draws snapshots
+	std::array<RenderSnapshot, 2> snapshots;
+	std::size_t front = 0;
+	snapshots[front].capture(world, population);
+	FrameWorker simulation;
+	JobSystem jobs{std::max(2u, std::thread::hardware_concurrency()) - 1}; //the simulation thread plus helpers; the main thread draws
+	SimulationGraph simGraph{world, tree.brain, population};
 	while(!window.should_close()){
 		float deltaTime = GetFrameTime();		
 		if(IsKeyPressed(KEY_SPACE)){ 
 			isPaused = !isPaused; 
 		}
 		if(IsKeyPressed(KEY_F)){ 
-			world.wolf_active = !world.wolf_active; 
+			world.set_wolf_active(!world.wolf_active);
+		}
+		if(IsKeyPressed(KEY_W)){
+			world.place_wolf(GetMousePosition());
+		}
+		if(IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD)){
+			population.spawn(spawn_batch, rng);
 		}
-		if(!isPaused){
-			update(world, tree, entities, deltaTime);
+		if(IsKeyPressed(KEY_MINUS) || IsKeyPressed(KEY_KP_SUBTRACT)){
+			for(std::size_t n = std::min(spawn_batch, population.size()); n > 0; --n){
+				const auto victim = static_cast<std::size_t>(rng.range(0, static_cast<int>(population.size()) - 1));
+				std::ignore = population.despawn(population.handle_at(victim));
+			}
 		}
-		render(world, entities);
+		RenderSnapshot& back = snapshots[front ^ 1];
+		simulation.kick([&world, &population, &jobs, &simGraph, &back, deltaTime, isPaused]{
+			if(isPaused){
+				back.capture(world, population);
+				return;
+			}
+			simGraph.step(jobs, deltaTime, &back);
+		});
+		render(snapshots[front]);
+		simulation.wait();
+		front ^= 1;
 	}
 	return 0;
 }
\ No newline at end of file
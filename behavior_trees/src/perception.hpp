@@ -0,0 +1,181 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+#include "world.hpp"
+#include "keys.hpp"
+#include "simd.hpp"
+
+// Perception: what every agent can sense this frame, computed for the whole population in
+// one pass before the tree is ticked. Leaves read these cached values instead of measuring
+// the same distances on their own (ThreatNearby and DoFlee both needed the wolf, ...).
+//
+// Distances are straight-line. Directions are unit vectors toward the target, taken from the
+// shared flow fields (the straight line when a field has nothing to route around), and ZERO
+// when standing exactly on the target.
+//
+// Rows line up with the pool's dense index. Everything is rebuilt every frame, so spawning
+// and despawning need no bookkeeping here.
+
+struct Sense final{
+    float dist = 0.0f;
+    Vector2 dir = ZERO;
+};
+
+// One target kind for every agent, structure-of-arrays.
+struct SenseColumn final{
+    std::vector<float> dist;
+    std::vector<float> dir_x;
+    std::vector<float> dir_y;
+
+    void resize(std::size_t count){
+        dist.resize(count);
+        dir_x.resize(count);
+        dir_y.resize(count);
+    }
+    void reserve(std::size_t count){
+        dist.reserve(count);
+        dir_x.reserve(count);
+        dir_y.reserve(count);
+    }
+
+    Sense operator[](std::size_t i) const noexcept{
+        return {dist[i], {dir_x[i], dir_y[i]}};
+    }
+};
+
+struct Senses final{
+    SenseColumn threat;               //the wolf; dist is +infinity while it is inactive, and may be for agents whose ThreatSafeUntil holds
+    SenseColumn food;
+    SenseColumn waypoint;             //the agent's current WaypointIndex
+    std::vector<int> waypoint_index;  //waypoint each row was sensed for, -1 if the tree has none
+    std::uint32_t food_serial = 0;    //world.food_serial when the food was sensed
+
+    // kernel inputs, gathered from the entities' AoS records
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> target_x;
+    std::vector<float> target_y;
+
+    std::size_t size() const noexcept{ return pos_x.size(); }
+
+    void reserve(std::size_t count){ //perceive_begin() resizes every column
+        threat.reserve(count);
+        food.reserve(count);
+        waypoint.reserve(count);
+        waypoint_index.reserve(count);
+        pos_x.reserve(count);
+        pos_y.reserve(count);
+        target_x.reserve(count);
+        target_y.reserve(count);
+    }
+};
+
+// The scalar path: what a leaf computes for itself when the cached value is stale.
+static Sense sense(Vector2 from, Vector2 target, const FlowField& field) noexcept{
+    return {Vector2Distance(from, target), field.direction(from)};
+}
+
+// dist and straight-line direction from lanes [i, i+n) to (tx, ty)
+static void sense_block(const Senses& s, SenseColumn& out, std::size_t i, std::size_t n, simd::f32 tx, simd::f32 ty) noexcept{
+    using namespace simd;
+    const f32 zero = set1(0.0f);
+    const f32 dx = tx - load_n(&s.pos_x[i], n);
+    const f32 dy = ty - load_n(&s.pos_y[i], n);
+    const f32 len2 = dx * dx + dy * dy;
+    const f32 inv = select(greater(len2, zero), rsqrt(len2), zero); //standing on the target: ZERO, like Vector2Normalize
+    store_n(&out.dist[i], sqrt(len2), n);
+    store_n(&out.dir_x[i], dx * inv, n);
+    store_n(&out.dir_y[i], dy * inv, n);
+}
+
+// Replaces straight-line directions with the field's where it routes around obstacles.
+// Scalar: sampling a field is a table lookup per agent.
+static void route_along(const Senses& s, SenseColumn& out, const FlowField& field, std::size_t i) noexcept{
+    const Vector2 from{s.pos_x[i], s.pos_y[i]};
+    const Vector2 dir = field.is_building() ? field.direction(from) : field.direction(from, {out.dir_x[i], out.dir_y[i]});
+    out.dir_x[i] = dir.x;
+    out.dir_y[i] = dir.y;
+}
+
+// Sizes the columns for `count` agents and stamps the frame-wide values. perceive() does this;
+// callers that split the pass over threads call it once, then perceive_rows() per chunk.
+static void perceive_begin(const World& world, std::size_t count, Senses& s){
+    s.pos_x.resize(count);
+    s.pos_y.resize(count);
+    s.threat.resize(count);
+    s.food.resize(count);
+    s.waypoint.resize(count);
+    s.waypoint_index.resize(count);
+    s.target_x.resize(count);
+    s.target_y.resize(count);
+    s.food_serial = world.food_serial;
+}
+
+// Senses rows [first, last). Rows only read their own entity and blackboard row.
+static void perceive_rows(const World& world, std::span<const Entity> entities, const Blackboard& board, Senses& s, std::size_t first, std::size_t last) noexcept{
+    using namespace simd;
+    assert(last <= s.size() && entities.size() == s.size());
+    const std::size_t count = last - first;
+    for(std::size_t i = first; i < last; ++i){
+        s.pos_x[i] = entities[i].position.x;
+        s.pos_y[i] = entities[i].position.y;
+    }
+
+    auto unreachable = [&](std::size_t from, std::size_t to){
+        std::fill(s.threat.dist.begin() + from, s.threat.dist.begin() + to, std::numeric_limits<float>::infinity());
+        std::fill(s.threat.dir_x.begin() + from, s.threat.dir_x.begin() + to, 0.0f);
+        std::fill(s.threat.dir_y.begin() + from, s.threat.dir_y.begin() + to, 0.0f);
+    };
+    if(world.wolf_active){
+        const f32 wx = set1(world.wolf_pos.x), wy = set1(world.wolf_pos.y);
+        const bool bounded = board.has<ThreatSafeUntil>();
+        for_each_block(count, [&](std::size_t i, std::size_t n){
+            i += first;
+            if(bounded){ //a block where every agent is provably out of reach is not measured at all
+                bool safe = true;
+                for(std::size_t k = i; k < i + n && safe; ++k){ safe = board.get<ThreatSafeUntil>(k).holds(world.time, world.threat_epoch); }
+                if(safe){
+                    unreachable(i, i + n);
+                    return;
+                }
+            }
+            sense_block(s, s.threat, i, n, wx, wy);
+        });
+        if(!world.wolf_field.is_trivial()){
+            for(std::size_t i = first; i < last; ++i){
+                if(s.threat.dist[i] < World::danger_radius){ route_along(s, s.threat, world.wolf_field, i); } //beyond it the field is the straight line anyway
+            }
+        }
+    } else{
+        unreachable(first, last);
+    }
+
+    const f32 fx = set1(world.food_pos.x), fy = set1(world.food_pos.y);
+    for_each_block(count, [&](std::size_t i, std::size_t n){ sense_block(s, s.food, first + i, n, fx, fy); });
+    if(!world.food_field.is_trivial()){
+        for(std::size_t i = first; i < last; ++i){ route_along(s, s.food, world.food_field, i); }
+    }
+
+    if(!board.has<WaypointIndex>()){
+        std::fill(s.waypoint_index.begin() + first, s.waypoint_index.begin() + last, -1);
+        return;
+    }
+    for(std::size_t i = first; i < last; ++i){
+        const int w = board.get<WaypointIndex>(i);
+        s.waypoint_index[i] = w;
+        s.target_x[i] = world.waypoints[w].x;
+        s.target_y[i] = world.waypoints[w].y;
+    }
+    for_each_block(count, [&](std::size_t i, std::size_t n){
+        sense_block(s, s.waypoint, first + i, n, load_n(&s.target_x[first + i], n), load_n(&s.target_y[first + i], n));
+    });
+    if(world.grid.obstacle_count > 0){
+        for(std::size_t i = first; i < last; ++i){ route_along(s, s.waypoint, world.waypoint_fields[s.waypoint_index[i]], i); }
+    }
+}
+
+// Call after world.update() and before ticking. `board` supplies each agent's WaypointIndex.
+static void perceive(const World& world, std::span<const Entity> entities, const Blackboard& board, Senses& s){
+    perceive_begin(world, entities.size(), s);
+    perceive_rows(world, entities, board, s, 0, entities.size());
+}
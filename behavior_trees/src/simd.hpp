@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Minimal float vector wrapper used by the batch kernels (steering, perception, ...).
+// The backend is picked at compile time: AVX (8 lanes) when the compiler targets it
+// (/arch:AVX2 on MSVC, -mavx2 or -march=native on gcc/clang), SSE2 (4 lanes) on any
+// x64 build, and a 1-lane scalar fallback everywhere else. Kernels are written once
+// against this interface and must handle the tail (count % width) themselves.
+#if defined(__AVX2__) || defined(__AVX__)
+#define BT_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BT_SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#include <cmath>
+#endif
+
+namespace simd{
+
+#if defined(BT_SIMD_AVX)
+    constexpr std::size_t width = 8;
+    constexpr const char* backend = "AVX";
+    struct f32{ __m256 v; };
+    inline f32 load(const float* p) noexcept{ return {_mm256_loadu_ps(p)}; }
+    inline void store(float* p, f32 a) noexcept{ _mm256_storeu_ps(p, a.v); }
+    inline f32 set1(float x) noexcept{ return {_mm256_set1_ps(x)}; }
+    inline f32 operator+(f32 a, f32 b) noexcept{ return {_mm256_add_ps(a.v, b.v)}; }
+    inline f32 operator-(f32 a, f32 b) noexcept{ return {_mm256_sub_ps(a.v, b.v)}; }
+    inline f32 operator*(f32 a, f32 b) noexcept{ return {_mm256_mul_ps(a.v, b.v)}; }
+    inline f32 min(f32 a, f32 b) noexcept{ return {_mm256_min_ps(a.v, b.v)}; }
+    inline f32 max(f32 a, f32 b) noexcept{ return {_mm256_max_ps(a.v, b.v)}; }
+    inline f32 less(f32 a, f32 b) noexcept{ return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+    inline f32 greater(f32 a, f32 b) noexcept{ return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+    inline f32 select(f32 mask, f32 if_true, f32 if_false) noexcept{ return {_mm256_blendv_ps(if_false.v, if_true.v, mask.v)}; }
+    inline std::uint32_t bits(f32 mask) noexcept{ return static_cast<std::uint32_t>(_mm256_movemask_ps(mask.v)); }
+    inline f32 rsqrt_approx(f32 a) noexcept{ return {_mm256_rsqrt_ps(a.v)}; }
+    inline f32 sqrt(f32 a) noexcept{ return {_mm256_sqrt_ps(a.v)}; }
+#elif defined(BT_SIMD_SSE)
+    constexpr std::size_t width = 4;
+    constexpr const char* backend = "SSE2";
+    struct f32{ __m128 v; };
+    inline f32 load(const float* p) noexcept{ return {_mm_loadu_ps(p)}; }
+    inline void store(float* p, f32 a) noexcept{ _mm_storeu_ps(p, a.v); }
+    inline f32 set1(float x) noexcept{ return {_mm_set1_ps(x)}; }
+    inline f32 operator+(f32 a, f32 b) noexcept{ return {_mm_add_ps(a.v, b.v)}; }
+    inline f32 operator-(f32 a, f32 b) noexcept{ return {_mm_sub_ps(a.v, b.v)}; }
+    inline f32 operator*(f32 a, f32 b) noexcept{ return {_mm_mul_ps(a.v, b.v)}; }
+    inline f32 min(f32 a, f32 b) noexcept{ return {_mm_min_ps(a.v, b.v)}; }
+    inline f32 max(f32 a, f32 b) noexcept{ return {_mm_max_ps(a.v, b.v)}; }
+    inline f32 less(f32 a, f32 b) noexcept{ return {_mm_cmplt_ps(a.v, b.v)}; }
+    inline f32 greater(f32 a, f32 b) noexcept{ return {_mm_cmpgt_ps(a.v, b.v)}; }
+    inline f32 select(f32 mask, f32 if_true, f32 if_false) noexcept{ //SSE2 has no blendv
+        return {_mm_or_ps(_mm_and_ps(mask.v, if_true.v), _mm_andnot_ps(mask.v, if_false.v))};
+    }
+    inline std::uint32_t bits(f32 mask) noexcept{ return static_cast<std::uint32_t>(_mm_movemask_ps(mask.v)); }
+    inline f32 rsqrt_approx(f32 a) noexcept{ return {_mm_rsqrt_ps(a.v)}; }
+    inline f32 sqrt(f32 a) noexcept{ return {_mm_sqrt_ps(a.v)}; }
+#else
+    constexpr std::size_t width = 1;
+    constexpr const char* backend = "scalar";
+    struct f32{ float v; };
+    inline f32 load(const float* p) noexcept{ return {*p}; }
+    inline void store(float* p, f32 a) noexcept{ *p = a.v; }
+    inline f32 set1(float x) noexcept{ return {x}; }
+    inline f32 operator+(f32 a, f32 b) noexcept{ return {a.v + b.v}; }
+    inline f32 operator-(f32 a, f32 b) noexcept{ return {a.v - b.v}; }
+    inline f32 operator*(f32 a, f32 b) noexcept{ return {a.v * b.v}; }
+    inline f32 min(f32 a, f32 b) noexcept{ return {a.v < b.v ? a.v : b.v}; }
+    inline f32 max(f32 a, f32 b) noexcept{ return {a.v > b.v ? a.v : b.v}; }
+    inline f32 less(f32 a, f32 b) noexcept{ return {a.v < b.v ? 1.0f : 0.0f}; }
+    inline f32 greater(f32 a, f32 b) noexcept{ return {a.v > b.v ? 1.0f : 0.0f}; }
+    inline f32 select(f32 mask, f32 if_true, f32 if_false) noexcept{ return mask.v != 0.0f ? if_true : if_false; }
+    inline std::uint32_t bits(f32 mask) noexcept{ return mask.v != 0.0f ? 1u : 0u; }
+    inline f32 rsqrt_approx(f32 a) noexcept{ return {1.0f / std::sqrt(a.v)}; }
+    inline f32 sqrt(f32 a) noexcept{ return {std::sqrt(a.v)}; }
+#endif
+
+    // Hardware rsqrt is accurate to ~12 bits (relative error <= 1.5 * 2^-12).
+    // One Newton-Raphson step, y' = y * (1.5 - 0.5 * x * y * y), squares that error
+    // and brings it down to a few float ulps (measured <= 5e-7 relative).
+    inline f32 rsqrt(f32 x) noexcept{
+        const f32 y = rsqrt_approx(x);
+        return y * (set1(1.5f) - set1(0.5f) * x * y * y);
+    }
+
+    // Partial loads/stores for the tail of a batch. Unused lanes are filled with
+    // `pad` so kernels never feed garbage (or zero) into rsqrt.
+    inline f32 load_n(const float* p, std::size_t n, float pad = 1.0f) noexcept{
+        if(n == width) return load(p);
+        float tmp[width];
+        for(std::size_t k = 0; k < width; ++k){ tmp[k] = (k < n) ? p[k] : pad; }
+        return load(tmp);
+    }
+
+    inline void store_n(float* p, f32 a, std::size_t n) noexcept{
+        if(n == width){ store(p, a); return; }
+        float tmp[width];
+        store(tmp, a);
+        for(std::size_t k = 0; k < n; ++k){ p[k] = tmp[k]; }
+    }
+
+    // Calls body(first, lanes) for every block of `width` items, then once more for the tail.
+    template <typename Body>
+    inline void for_each_block(std::size_t count, Body&& body) noexcept{
+        std::size_t i = 0;
+        for(; i + width <= count; i += width){ body(i, width); }
+        if(i < count){ body(i, count - i); }
+    }
+} // namespace simd
@@ -0,0 +1,53 @@
+#pragma once
+#include "common.hpp"
+#include "entity-pool.hpp"
+#include "world.hpp"
+#include "behavior-tree.hpp"
+#include "game-ai.hpp"
+
+// Keeps the population's rows roughly in Morton order (spatial-order.hpp). A full re-sort every
+// `world.resort_period` frames: agents only drift a few cells in between, and the counting sort
+// plus the permute cost less than one frame, spread over the period.
+static void resort(const World& world, EntityPool& population){
+    if(world.resort_period != 0 && world.frame % world.resort_period == 0){ std::ignore = population.sort_spatially(); }
+}
+
+// The first half of prepare_step(): rewind the frame arena, re-sort the rows now and then,
+// advance the world and the agents' timers. Rows are final for the frame after it.
+static void advance(World& world, EntityPool& population, float dt) noexcept{
+    frame_arena().reset(); //last step's scratch (frame-arena.hpp)
+    resort(world, population);
+    world.update(dt);
+    update_hunger(world, population);
+}
+
+// Everything in a step before the tick: advance(), then sense the world and compute the flocking
+// forces. Returns whether flocking is on, in which case flock() adds each agent's force after its tick.
+static bool prepare_step(World& world, EntityPool& population, float dt) noexcept{
+    advance(world, population, dt);
+    perceive(world, population.entities(), population.board(), population.senses());
+    const bool flocking = flocking_enabled(world.tuning);
+    if(flocking){
+        population.neighbors().build(population.entities());
+        flock_rows(population.neighbors(), world.tuning, 0, NeighborGrid::rows);
+    }
+    return flocking;
+}
+
+// One simulation step: prepare_step(), then tick, flock and integrate every agent, then apply
+// the world writes the leaves deferred. Shared by the demo loop and the headless benchmarks.
+// SimulationGraph (frame-graph.hpp) runs the same step on a JobSystem with the same result.
+static void simulate(World& world, const EntityBrain& brain, EntityPool& population, float dt) noexcept{
+    const bool flocking = prepare_step(world, population, dt);
+    auto entities = population.entities();
+    auto memory = population.memory();
+    auto& board = population.board();
+    auto& senses = population.senses();
+    for(std::size_t i = 0; i < entities.size(); ++i){
+        Context ctx{entities[i], memory[i], world, board, senses, i, &world.commands};
+        std::ignore = brain.tick(ctx, dt);
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    apply_commands(world, population, {&world.commands, 1});
+}
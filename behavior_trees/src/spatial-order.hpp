@@ -0,0 +1,61 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+
+// Z-order (Morton) sort of the population by position.
+//
+// Agents move, so after a while their dense rows say nothing about where they are: the
+// neighbor grid gathers from all over the pool, and a SIMD block of perception holds agents
+// from all over the stage. Sorting the rows by the Morton key of their cell puts agents that
+// are near each other in space near each other in memory, in both directions at once.
+//
+// The key is a cell of `cell_size` pixels with the bits of its column and row interleaved, and
+// the whole stage has fewer than 2^14 cells, so the sort is one stable counting sort.
+// EntityPool::sort_spatially() applies the order to every per-agent array; handles stay valid.
+
+struct MortonOrder final{
+    static constexpr float cell_size = 16.0f;
+    static constexpr int bits = 7; //per axis
+    static constexpr std::uint32_t key_count = 1u << (2 * bits);
+    static_assert(STAGE_WIDTH / cell_size < (1 << bits) && STAGE_HEIGHT / cell_size < (1 << bits));
+
+    // 0b0000abcd -> 0b0a0b0c0d
+    static constexpr std::uint32_t spread(std::uint32_t v) noexcept{
+        v = (v | (v << 4)) & 0x0F0Fu;
+        v = (v | (v << 2)) & 0x3333u;
+        v = (v | (v << 1)) & 0x5555u;
+        return v;
+    }
+
+    static std::uint32_t key(Vector2 p) noexcept{
+        constexpr float inv = 1.0f / cell_size;
+        constexpr int last = (1 << bits) - 1;
+        const auto x = static_cast<std::uint32_t>(std::clamp(to_int(p.x * inv), 0, last));
+        const auto y = static_cast<std::uint32_t>(std::clamp(to_int(p.y * inv), 0, last));
+        return spread(x) | (spread(y) << 1);
+    }
+
+    // order[i] = current row of the agent that belongs at row i. Agents in the same cell keep
+    // their relative order. Empty if the rows already are in Morton order.
+    std::span<const std::uint32_t> order(std::span<const Entity> entities){
+        const std::size_t n = entities.size();
+        keys_.resize(n);
+        start_.assign(key_count + 1, 0);
+        bool sorted = true;
+        for(std::size_t i = 0; i < n; ++i){
+            keys_[i] = key(entities[i].position);
+            ++start_[keys_[i] + 1];
+            sorted = sorted && (i == 0 || keys_[i - 1] <= keys_[i]);
+        }
+        if(sorted) return {};
+        for(std::uint32_t k = 0; k < key_count; ++k){ start_[k + 1] += start_[k]; }
+        order_.resize(n);
+        for(std::size_t i = 0; i < n; ++i){ order_[start_[keys_[i]]++] = static_cast<std::uint32_t>(i); }
+        return order_;
+    }
+
+private:
+    std::vector<std::uint32_t> keys_;
+    std::vector<std::uint32_t> start_;
+    std::vector<std::uint32_t> order_;
+};
@@ -0,0 +1,287 @@
+#pragma once
+#include "common.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "frame-arena.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+
+// Squads: agents in groups that decide together.
+//
+// A squad is an entity of its own, in a second EntityPool: its position and velocity are the mean
+// of its members', and it runs SquadTree once per frame: flee as one when the wolf is near any
+// member, otherwise patrol the waypoints in turn. The decision is published to every member as a
+// Directive on its blackboard row. The members run MemberTree, a short Selector that carries the
+// directive out: flee, or steer for the squad's waypoint, unless the agent is hungry. Steering,
+// hunger and eating stay per agent; the decision tree runs once per squad.
+//
+// Membership changes as the agents move. A member that strays further than `leash` from its
+// squad's centre leaves it, and so do the members of squads smaller than `min_size`. Agents
+// without a squad join the fullest squad with room whose centre is in the same `join_cell`, or
+// found a new one; so small squads merge, and the number of squads levels off instead of growing
+// with every stray. How full they get depends on how crowded the stage is, not on merging alone:
+// `benchmarks squads` averages 8 members per squad at 2k agents and 23 at 20k, of `capacity`.
+// Squads that lose all members are despawned.
+// Everything is recomputed in row order, so runs are deterministic.
+
+// The member's squad; none (an invalid handle) until it joins one.
+struct SquadOf final : BlackboardKey<EntityHandle, SquadOfKey>{};
+
+// What a squad decided on its last tick: Flee, or Patrol towards `waypoint`.
+struct Directive final{
+    Activity order = Activity::None;
+    std::uint8_t waypoint = 0;
+};
+struct SquadDirective final : BlackboardKey<Directive, SquadDirectiveKey>{};
+
+// A squad's members this frame: how many, their RMS distance from its centre, and the distance
+// of the one furthest out.
+struct Formation final{
+    std::uint32_t size = 0;
+    float spread = 0.0f;
+    float reach = 0.0f;
+};
+struct SquadFormation final : BlackboardKey<Formation, SquadFormationKey>{};
+
+// --- Squad leaves: ticked with a squad as ctx.self ---
+// The wolf may be within the threat radius of some member: it is within that radius of a circle
+// around the centre holding every member. Members do not look for the wolf themselves.
+static Status SquadThreatened(Context& ctx, float) noexcept{
+    const float reach = ctx.world.tuning.threat_radius + ctx.get<SquadFormation>().reach;
+    return (ctx.senses.threat.dist[ctx.index] < reach) ? Status::Success : Status::Failure;
+}
+
+static Status OrderFlee(Context& ctx, float) noexcept{
+    ctx.self.activity = Activity::Flee;
+    ctx.set<SquadDirective>({Activity::Flee, 0});
+    return Status::Running;
+}
+
+// Sends the members to the squad's waypoint; done once the squad has gathered around it.
+static Status OrderPatrol(Context& ctx, float) noexcept{
+    const int corner = ctx.get<WaypointIndex>();
+    ctx.self.activity = Activity::Patrol;
+    ctx.set<SquadDirective>({Activity::Patrol, static_cast<std::uint8_t>(corner)});
+    const Sense waypoint = sensed_waypoint(ctx, corner);
+    return (waypoint.dist <= World::waypoint_radius + ctx.get<SquadFormation>().spread) ? Status::Success : Status::Running;
+}
+
+// --- Member leaves ---
+static Status SquadFleeing(Context& ctx, float) noexcept{
+    return (ctx.get<SquadDirective>().order == Activity::Flee) ? Status::Success : Status::Failure;
+}
+
+static Status FollowSquad(Context& ctx, float dt) noexcept{
+    ctx.set<WaypointIndex>(ctx.get<SquadDirective>().waypoint);
+    std::ignore = MoveToCorner(ctx, dt); //arriving is the squad's call
+    return Status::Running;
+}
+
+// DemoTree's decisions, made once per squad.
+struct SquadTree final{
+    using Keys = KeySet<WaypointIndex, SquadDirective, SquadFormation>;
+
+    Leaf threatened{SquadThreatened, condition("SquadThreatened", reads_self | reads_world(WorldInput::WolfPosition) | reads_world(WorldInput::WolfActive) | reads_key<SquadFormation>)};
+    Leaf flee{OrderFlee, action("OrderFlee", outcome(Status::Running))};
+    Sequence fleeSeq{&threatened, &flee};
+
+    Leaf moveToCorner{OrderPatrol, action("OrderPatrol", outcome(Status::Success) | outcome(Status::Running))};
+    Leaf advanceCorner{AdvanceCorner, action("AdvanceCorner", outcome(Status::Success))};
+    MemorySequence patrolSeq{0, {&moveToCorner, &advanceCorner}};
+    RepeatForever patrolLoop{&patrolSeq};
+
+    Selector root{&fleeSeq, &patrolLoop};
+    EntityBrain brain{&root};
+};
+
+// What is left per agent: follow the squad's directive, or go eat.
+struct MemberTree final{
+    using Keys = KeySet<WaypointIndex, IsHungry, Hunger, SquadOf, SquadDirective>;
+
+    Leaf fleeing{SquadFleeing, condition("SquadFleeing", reads_key<SquadDirective>)};
+    Leaf flee{DoFlee, action("DoFlee", outcome(Status::Running)), DoFleeRows};
+    Sequence fleeSeq{&fleeing, &flee};
+
+    Leaf hungry{CheckHunger, condition("CheckHunger", reads_key<IsHungry>), CheckHungerRows};
+    Leaf seekFood{DoSeekFood, action("DoSeekFood", outcome(Status::Success) | outcome(Status::Running)), DoSeekFoodRows};
+    Sequence foodSeq{&hungry, &seekFood};
+
+    Leaf follow{FollowSquad, action("FollowSquad", outcome(Status::Running))};
+
+    Selector root{&fleeSeq, &foodSeq, &follow};
+    EntityBrain brain{&root};
+};
+
+struct Squads final{
+    static constexpr std::uint32_t capacity = 32; //members per squad at most
+    static constexpr float leash = 96.0f;          //a member further than this from its squad's centre leaves it
+    static constexpr std::uint32_t min_size = 4;   //members of a smaller squad rejoin, to merge it into a fuller one
+    static constexpr float join_cell = 64.0f;      //agents without a squad join one centred in the same cell
+    static constexpr int cols = static_cast<int>(STAGE_WIDTH / join_cell) + 1;
+    static constexpr int rows = static_cast<int>(STAGE_HEIGHT / join_cell) + 1;
+
+    EntityPool pool{Blackboard{SquadTree::Keys{}}};
+
+    // Squads founded, squads dissolved and members that left their squad, on the last tick().
+    std::size_t formed() const noexcept{ return formed_; }
+    std::size_t dissolved() const noexcept{ return dissolved_; }
+    std::size_t strays() const noexcept{ return strays_; }
+
+    // Once per frame, after the members were sensed and before their tick: regroup, sense and
+    // tick every squad, and publish the directives to the members.
+    void tick(World& world, const EntityBrain& brain, EntityPool& members, float dt){
+        regroup(members);
+        perceive(world, pool.entities(), pool.board(), pool.senses());
+        auto squads = pool.entities();
+        auto memory = pool.memory();
+        for(std::size_t s = 0; s < squads.size(); ++s){
+            if(pool.board().get<SquadFormation>(s).size == 0) continue; //dissolved on the next regroup
+            Context ctx{squads[s], memory[s], world, pool.board(), pool.senses(), s, nullptr};
+            std::ignore = brain.tick(ctx, dt);
+        }
+        publish(members, world.frame);
+    }
+
+private:
+    struct Sum final{
+        Vector2 position = ZERO;
+        Vector2 velocity = ZERO;
+        float spread = 0.0f;
+        float reach = 0.0f;   //squared, until the end of regroup()
+        std::uint32_t size = 0;
+    };
+
+    std::vector<Sum> sums_;                  //per squad row
+    std::vector<std::uint32_t> squad_row_;   //per member: its squad's row, until the next regroup
+    std::vector<EntityHandle> cells_;        //per join_cell: the fullest squad centred there with room
+    std::size_t formed_ = 0;
+    std::size_t dissolved_ = 0;
+    std::size_t strays_ = 0;
+
+    static std::size_t cell_of(Vector2 p) noexcept{
+        const int x = std::clamp(static_cast<int>(p.x / join_cell), 0, cols - 1);
+        const int y = std::clamp(static_cast<int>(p.y / join_cell), 0, rows - 1);
+        return static_cast<std::size_t>(y * cols + x);
+    }
+
+    void add(std::size_t s, std::size_t member, const Entity& e) noexcept{
+        sums_[s].position += e.position;
+        sums_[s].velocity += e.velocity;
+        ++sums_[s].size;
+        squad_row_[member] = static_cast<std::uint32_t>(s);
+    }
+
+    // Membership and the squads' centres, from the members' positions this frame. Squads left
+    // empty are despawned on the next call, so squad rows stay put until the members' tick is over.
+    void regroup(EntityPool& members){
+        // Squads come and go every frame, their arrays stay put. At most one squad per member
+        // outlives the last frame, and each joiner founds at most one more, so 2 per member is
+        // the most there can be.
+        pool.reserve(2 * members.size());
+        sums_.reserve(2 * members.size());
+        dissolved_ = 0;
+        for(std::size_t s = pool.size(); s-- > 0;){ //from the back: despawn() fills row s with a row already checked
+            if(pool.board().get<SquadFormation>(s).size != 0) continue;
+            std::ignore = pool.despawn(pool.handle_at(s));
+            ++dissolved_;
+        }
+
+        auto entities = members.entities();
+        auto squad_of = members.board().column<SquadOf>();
+        const auto wanted = members.board().column<WaypointIndex>();
+        const auto centres = pool.entities();
+        sums_.assign(pool.size(), Sum{});
+        squad_row_.resize(entities.size());
+        FrameVector<std::uint32_t> joiners{ArenaAllocator<std::uint32_t>{frame_arena()}}; //members without a squad
+        joiners.reserve(entities.size());
+        formed_ = strays_ = 0;
+
+        for(std::size_t i = 0; i < entities.size(); ++i){ //stay, stray, or rejoin
+            const EntityHandle h = squad_of[i];
+            if(pool.alive(h)){
+                const std::size_t s = pool.index_of(h);
+                if(pool.board().get<SquadFormation>(s).size >= min_size){ //last frame's
+                    if(Vector2DistanceSqr(entities[i].position, centres[s].position) <= leash * leash){
+                        add(s, i, entities[i]);
+                        continue;
+                    }
+                    ++strays_;
+                }
+            }
+            joiners.push_back(static_cast<std::uint32_t>(i));
+        }
+
+        cells_.assign(static_cast<std::size_t>(cols * rows), EntityHandle{});
+        for(std::size_t s = 0; s < centres.size(); ++s){
+            if(sums_[s].size >= capacity) continue;
+            EntityHandle& open = cells_[cell_of(centres[s].position)];
+            if(!pool.alive(open) || sums_[pool.index_of(open)].size < sums_[s].size){ open = pool.handle_at(s); }
+        }
+        for(const auto i : joiners){
+            const Entity& e = entities[i];
+            EntityHandle& open = cells_[cell_of(e.position)];
+            std::size_t s = 0;
+            if(pool.alive(open) && sums_[s = pool.index_of(open)].size < capacity){
+                squad_of[i] = open;
+            } else{ //found a squad where the agent stands, heading for the agent's own waypoint
+                Entity centre;
+                centre.position = e.position;
+                centre.velocity = e.velocity;
+                open = squad_of[i] = pool.spawn(centre);
+                s = pool.size() - 1;
+                pool.board().get<WaypointIndex>(s) = wanted[i];
+                sums_.emplace_back();
+                ++formed_;
+            }
+            add(s, i, e);
+        }
+        std::ignore = pool.take_spawned(); //nothing to schedule for squads
+
+        auto squads = pool.entities();
+        for(std::size_t s = 0; s < squads.size(); ++s){
+            const Sum& sum = sums_[s];
+            if(sum.size == 0) continue;
+            const float n = static_cast<float>(sum.size);
+            squads[s].position = sum.position / n;
+            squads[s].velocity = sum.velocity / n;
+        }
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            const std::size_t s = squad_row_[i];
+            const float d2 = Vector2DistanceSqr(entities[i].position, squads[s].position);
+            sums_[s].spread += d2;
+            sums_[s].reach = std::max(sums_[s].reach, d2);
+        }
+        auto& board = pool.board();
+        for(std::size_t s = 0; s < squads.size(); ++s){
+            const Sum& sum = sums_[s];
+            const float spread = (sum.size != 0) ? std::sqrt(sum.spread / static_cast<float>(sum.size)) : 0.0f;
+            board.get<SquadFormation>(s) = {sum.size, spread, std::sqrt(sum.reach)};
+        }
+    }
+
+    void publish(EntityPool& members, std::uint32_t frame) noexcept{
+        auto& board = members.board();
+        const auto& orders = pool.board();
+        for(std::size_t i = 0; i < squad_row_.size(); ++i){
+            board.set<SquadDirective>(i, orders.get<SquadDirective>(squad_row_[i]), frame);
+        }
+    }
+};
+
+// simulate() for a population in squads: prepare_step(), then the squads' tick, then each
+// member's tick, flocking and integration, then the deferred world writes.
+static void simulate(World& world, Squads& squads, const EntityBrain& squad_brain, const EntityBrain& member_brain, EntityPool& population, float dt){
+    const bool flocking = prepare_step(world, population, dt);
+    squads.tick(world, squad_brain, population, dt);
+    auto entities = population.entities();
+    auto memory = population.memory();
+    auto& board = population.board();
+    auto& senses = population.senses();
+    for(std::size_t i = 0; i < entities.size(); ++i){
+        Context ctx{entities[i], memory[i], world, board, senses, i, &world.commands};
+        std::ignore = member_brain.tick(ctx, dt);
+        if(flocking){ flock(population.neighbors(), entities[i], i); }
+        entities[i].update(dt);
+    }
+    apply_commands(world, population, {&world.commands, 1});
+}
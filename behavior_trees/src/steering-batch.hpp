@@ -0,0 +1,75 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+#include "simd.hpp"
+
+// Batch versions of steer_seek / steer_flee / steer_drag.
+// They work on structure-of-arrays views instead of a single Entity, and accumulate
+// into the acceleration arrays (acc += force) just like the leaves do with the scalar helpers.
+// Normalization uses simd::rsqrt (hardware estimate + one Newton step) instead of
+// Vector2Normalize's sqrt + divide.
+//
+// Accuracy: per component, |batch - scalar| <= batch_steering_tolerance * weight * (max_speed + |velocity|).
+// The benchmark ("steering") checks this bound against the scalar helpers on random input.
+constexpr float batch_steering_tolerance = 2e-6f;
+
+struct SteeringBatch final{
+    std::span<const float> pos_x;
+    std::span<const float> pos_y;
+    std::span<const float> vel_x;
+    std::span<const float> vel_y;
+    std::span<float> acc_x;
+    std::span<float> acc_y;
+
+    std::size_t size() const noexcept{
+        assert(pos_y.size() == pos_x.size() && vel_x.size() == pos_x.size() && vel_y.size() == pos_x.size());
+        assert(acc_x.size() == pos_x.size() && acc_y.size() == pos_x.size());
+        return pos_x.size();
+    }
+};
+
+static void steer_seek(SteeringBatch& b, Vector2 targetPos, float max_speed, float weight = Entity::seek_weight) noexcept{
+    using namespace simd;
+    const f32 tx = set1(targetPos.x), ty = set1(targetPos.y);
+    const f32 speed = set1(max_speed), w = set1(weight), zero = set1(0.0f);
+    for_each_block(b.size(), [&](std::size_t i, std::size_t n){
+        const f32 dx = tx - load_n(&b.pos_x[i], n);
+        const f32 dy = ty - load_n(&b.pos_y[i], n);
+        const f32 len2 = dx * dx + dy * dy;
+        //Vector2Normalize leaves a zero vector alone; mirror that instead of producing NaN.
+        const f32 scale = select(greater(len2, zero), rsqrt(len2) * speed, zero);
+        const f32 ax = (dx * scale - load_n(&b.vel_x[i], n)) * w;
+        const f32 ay = (dy * scale - load_n(&b.vel_y[i], n)) * w;
+        store_n(&b.acc_x[i], load_n(&b.acc_x[i], n) + ax, n);
+        store_n(&b.acc_y[i], load_n(&b.acc_y[i], n) + ay, n);
+    });
+}
+
+static void steer_flee(SteeringBatch& b, Vector2 threatPos, float max_speed, float weight = Entity::flee_weight) noexcept{
+    using namespace simd;
+    const f32 tx = set1(threatPos.x), ty = set1(threatPos.y);
+    const f32 speed = set1(max_speed), w = set1(weight);
+    const f32 epsilon = set1(0.0001f), one = set1(1.0f), zero = set1(0.0f);
+    for_each_block(b.size(), [&](std::size_t i, std::size_t n){
+        f32 dx = load_n(&b.pos_x[i], n) - tx;
+        f32 dy = load_n(&b.pos_y[i], n) - ty;
+        //same degenerate case as the scalar version: standing on the threat flees along +x
+        const f32 degenerate = less(dx * dx + dy * dy, epsilon);
+        dx = select(degenerate, one, dx);
+        dy = select(degenerate, zero, dy);
+        const f32 scale = rsqrt(dx * dx + dy * dy) * speed;
+        const f32 ax = (dx * scale - load_n(&b.vel_x[i], n)) * w;
+        const f32 ay = (dy * scale - load_n(&b.vel_y[i], n)) * w;
+        store_n(&b.acc_x[i], load_n(&b.acc_x[i], n) + ax, n);
+        store_n(&b.acc_y[i], load_n(&b.acc_y[i], n) + ay, n);
+    });
+}
+
+static void steer_drag(SteeringBatch& b) noexcept{
+    using namespace simd;
+    const f32 k = set1(-Entity::drag);
+    for_each_block(b.size(), [&](std::size_t i, std::size_t n){
+        store_n(&b.acc_x[i], load_n(&b.acc_x[i], n) + load_n(&b.vel_x[i], n) * k, n);
+        store_n(&b.acc_y[i], load_n(&b.acc_y[i], n) + load_n(&b.vel_y[i], n) * k, n);
+    });
+}
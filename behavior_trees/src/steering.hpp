@@ -18,4 +18,10 @@ static Vector2 steer_flee(const Entity& e, Vector2 threatPos, float max_speed) n
 
 static Vector2 steer_drag(const Entity& e) noexcept{
     return e.velocity * -Entity::drag;
+}
+
+// Steer along an already normalized direction, e.g. one sampled from a flow field.
+static Vector2 steer_along(const Entity& e, Vector2 direction, float max_speed, float weight) noexcept{
+    auto desired_velocity = direction * max_speed;
+    return (desired_velocity - e.velocity) * weight;
 }
\ No newline at end of file
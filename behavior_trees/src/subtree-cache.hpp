@@ -0,0 +1,94 @@
+#pragma once
+#include "behavior-tree.hpp"
+#include <bit>
+
+// CachedSubtree: remembers a condition subtree's last result per entity and skips
+// re-evaluating it until one of its inputs is written.
+//
+// The inputs are the union of what its leaves declare in LeafTraits::reads. Writes are
+// tracked by frame: Context::set / Blackboard::set stamp blackboard keys per entity, and
+// World's methods stamp the WorldInputs. A cached result from frame F is reused while
+// every input was last written before F; a write during F itself only costs one extra
+// evaluation on the next frame.
+//
+// Only subtrees made of pure conditions (LeafTraits::commutative) with declared inputs,
+// and nothing that changes every frame (reads_self), are cached. Anything else is ticked
+// through as usual and counted as uncached, so wrapping the wrong subtree is slow, never wrong.
+//
+// The result lives in the entity's bt_mem[mem_slot], as (frame << 2) | status; 0 = empty.
+
+struct CacheStats final{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t uncached = 0; //ticks of a subtree that cannot be cached
+
+    double hit_rate() const noexcept{
+        const auto total = hits + misses + uncached;
+        return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+struct CachedSubtree final : Node{
+    Node* child = nullptr;
+    int mem_slot = 0;
+    Inputs reads = 0;
+    bool cacheable = false;
+    mutable CacheStats stats; //single-threaded tick
+
+    CachedSubtree(int slot, Node* c) : child(c), mem_slot(slot){
+        cacheable = inspect(*child, reads) && (reads & reads_self) == 0;
+        key_mask = static_cast<std::uint32_t>(reads);
+        world_mask = static_cast<std::uint32_t>((reads >> 32) & ((1u << static_cast<unsigned>(WorldInput::Count)) - 1));
+    }
+
+    Status tick(Context& ctx, float dt) const noexcept override{
+        if(!cacheable){
+            ++stats.uncached;
+            return child->tick(ctx, dt);
+        }
+        assert(static_cast<std::size_t>(mem_slot) < ctx.memory.bt_mem.size());
+        auto& entry = reinterpret_cast<std::uint32_t&>(ctx.memory.bt_mem[mem_slot]);
+        if(entry != 0 && still_valid(ctx, entry >> 2)){
+            ++stats.hits;
+            return static_cast<Status>(entry & 3u);
+        }
+        ++stats.misses;
+        const Status s = child->tick(ctx, dt);
+        assert(ctx.world.frame < (1u << 30));
+        entry = (ctx.world.frame << 2) | static_cast<std::uint32_t>(s);
+        return s;
+    }
+
+private:
+    std::uint32_t key_mask = 0;
+    std::uint32_t world_mask = 0;
+
+    bool still_valid(const Context& ctx, std::uint32_t frame) const noexcept{
+        for(auto m = world_mask; m != 0; m &= m - 1){
+            if(ctx.world.written[std::countr_zero(m)] >= frame) return false;
+        }
+        for(auto m = key_mask; m != 0; m &= m - 1){
+            if(ctx.board.written(static_cast<std::size_t>(std::countr_zero(m)), ctx.index) >= frame) return false;
+        }
+        return true;
+    }
+
+    // Collects the inputs of a subtree; false if it contains anything that is not a pure condition.
+    static bool inspect(const Node& n, Inputs& reads) noexcept{
+        switch(n.kind()){
+        case NodeKind::Leaf:{
+            const auto& traits = static_cast<const Leaf&>(n).traits;
+            reads |= traits.reads;
+            return traits.commutative && traits.reads != reads_anything;
+        }
+        case NodeKind::Sequence:
+        case NodeKind::Selector:{
+            bool pure = true;
+            for(const Node* c : n.subtrees()){ pure = inspect(*c, reads) && pure; }
+            return pure;
+        }
+        default:
+            return false; //memory, Running, or opaque: not a pure function of its inputs
+        }
+    }
+};
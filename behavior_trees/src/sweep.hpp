@@ -0,0 +1,154 @@
+#pragma once
+#include "common.hpp"
+#include "tuning.hpp"
+#include "batch-runner.hpp"
+#include <cstdio>
+
+// Parameter sweeps over Tuning: evaluate many candidate Tunings as batched headless simulations
+// and rank them by a fitness score.
+//
+// Every candidate runs on the same `seeds` instances (same worlds, same starting populations),
+// so differences in score come from the Tuning and not from luck of the draw. All candidate x
+// seed runs of one evaluate() call are chunks of a single task graph, so they spread over every
+// core of the JobSystem.
+//
+// Three ways to pick candidates: grid() (every combination of `steps` values per parameter),
+// random_tunings(), and evolve() (keep the best, recombine and mutate them, repeat).
+
+// Score of one run. Survival is the fraction of agent-time spent out of the wolf's reach;
+// food rate is food eaten per agent per minute of simulated time.
+struct Fitness final{
+    double survival_weight = 1.0;
+    double food_weight = 1.0;
+
+    double survival(const InstanceStats& s) const noexcept{
+        return (s.agent_seconds > 0.0) ? 1.0 - s.caught_seconds / s.agent_seconds : 0.0;
+    }
+    double food_rate(const InstanceStats& s, std::size_t agents) const noexcept{
+        const double minutes = s.agent_seconds / static_cast<double>(std::max<std::size_t>(agents, 1)) / 60.0;
+        return (minutes > 0.0) ? s.food_eaten / minutes / static_cast<double>(std::max<std::size_t>(agents, 1)) : 0.0;
+    }
+    double operator()(const InstanceStats& s, std::size_t agents) const noexcept{
+        return survival_weight * survival(s) + food_weight * food_rate(s, agents);
+    }
+};
+
+struct SweepConfig final{
+    BatchConfig batch;          //agents, frames, dt and seed of every run; batch.tuning is ignored
+    std::size_t seeds = 4;      //instances per candidate
+    Fitness fitness;
+};
+
+struct SweepResult final{
+    Tuning tuning;
+    double fitness = 0.0;       //means over the seeds
+    double survival = 0.0;
+    double food_rate = 0.0;
+};
+
+// Scores every candidate. Results are in candidate order.
+static std::vector<SweepResult> evaluate(JobSystem& jobs, const EntityBrain& brain, std::span<const Tuning> candidates, const SweepConfig& config){
+    std::vector<SweepResult> results(candidates.size());
+    if(candidates.empty() || config.seeds == 0) return results;
+    std::vector<InstanceStats> runs(candidates.size() * config.seeds);
+    TaskGraph graph;
+    std::ignore = graph.add("run", [&](std::size_t i){
+        BatchConfig batch = config.batch;
+        batch.tuning = candidates[i / config.seeds];
+        runs[i] = run_instance(brain, batch, i % config.seeds);
+    }, runs.size());
+    jobs.run(graph);
+
+    const auto agents = config.batch.agents;
+    const double n = static_cast<double>(config.seeds);
+    for(std::size_t c = 0; c < candidates.size(); ++c){
+        SweepResult& r = results[c];
+        r.tuning = candidates[c];
+        for(std::size_t s = 0; s < config.seeds; ++s){
+            const InstanceStats& run = runs[c * config.seeds + s];
+            r.fitness += config.fitness(run, agents) / n;
+            r.survival += config.fitness.survival(run) / n;
+            r.food_rate += config.fitness.food_rate(run, agents) / n;
+        }
+    }
+    return results;
+}
+
+// Every combination of `steps` evenly spaced values (ends included) of the given parameters;
+// the others keep their value in `base`. steps^params candidates.
+static std::vector<Tuning> grid(const Tuning& base, std::size_t steps, std::span<const TuningParam> params = tuning_params){
+    assert(steps >= 1);
+    std::size_t total = 1;
+    for(std::size_t p = 0; p < params.size(); ++p){ total *= steps; }
+    std::vector<Tuning> out(total, base);
+    for(std::size_t i = 0; i < total; ++i){
+        std::size_t digits = i;
+        for(const auto& p : params){
+            const std::size_t k = digits % steps;
+            digits /= steps;
+            const float t = (steps > 1) ? static_cast<float>(k) / static_cast<float>(steps - 1) : 0.5f;
+            out[i].*p.field = p.min + (p.max - p.min) * t;
+        }
+    }
+    return out;
+}
+
+static std::vector<Tuning> random_tunings(std::size_t count, Rng& rng, std::span<const TuningParam> params = tuning_params){
+    std::vector<Tuning> out(count);
+    for(auto& t : out){
+        for(const auto& p : params){ t.*p.field = rng.range(p.min, p.max); }
+    }
+    return out;
+}
+
+static void rank(std::vector<SweepResult>& results) noexcept{
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b){ return a.fitness > b.fitness; });
+}
+
+// Simple generational search. The best quarter of each generation survives as is (and is not
+// scored again); the rest are children of two survivors (uniform crossover) with each parameter
+// mutated with probability `mutation` by up to 10% of its range.
+// Starts from `population` random Tunings plus the defaults. Returns every scored Tuning, ranked.
+static std::vector<SweepResult> evolve(JobSystem& jobs, const EntityBrain& brain, const SweepConfig& config,
+    std::size_t population, int generations, Rng& rng, float mutation = 0.3f){
+    assert(population >= 4);
+    const std::size_t elite = population / 4;
+    std::vector<Tuning> candidates = random_tunings(population - 1, rng);
+    candidates.push_back(Tuning{});
+    std::vector<SweepResult> current = evaluate(jobs, brain, candidates, config);
+    std::vector<SweepResult> all = current;
+    for(int g = 1; g < generations; ++g){
+        rank(current);
+        candidates.resize(population - elite);
+        for(auto& child : candidates){
+            const Tuning& a = current[static_cast<std::size_t>(rng.range(0, static_cast<int>(elite) - 1))].tuning;
+            const Tuning& b = current[static_cast<std::size_t>(rng.range(0, static_cast<int>(elite) - 1))].tuning;
+            for(const auto& p : tuning_params){
+                child.*p.field = (rng.range01() < 0.5f) ? a.*p.field : b.*p.field;
+                if(rng.range01() < mutation){
+                    const float step = (p.max - p.min) * 0.1f;
+                    child.*p.field = std::clamp(child.*p.field + rng.range(-step, step), p.min, p.max);
+                }
+            }
+        }
+        const auto children = evaluate(jobs, brain, candidates, config);
+        current.resize(elite);
+        current.insert(current.end(), children.begin(), children.end());
+        all.insert(all.end(), children.begin(), children.end());
+    }
+    rank(all);
+    return all;
+}
+
+// CSV, best first: rank, fitness, survival, food_rate, then one column per parameter.
+static void write_ranked(std::FILE* out, std::span<const SweepResult> ranked, std::size_t limit = std::numeric_limits<std::size_t>::max()){
+    std::fprintf(out, "rank,fitness,survival,food_rate");
+    for(const auto& p : tuning_params){ std::fprintf(out, ",%s", p.name); }
+    std::fprintf(out, "\n");
+    for(std::size_t i = 0; i < std::min(limit, ranked.size()); ++i){
+        const SweepResult& r = ranked[i];
+        std::fprintf(out, "%zu,%.5f,%.5f,%.4f", i + 1, r.fitness, r.survival, r.food_rate);
+        for(const auto& p : tuning_params){ std::fprintf(out, ",%.4g", r.tuning.*p.field); }
+        std::fprintf(out, "\n");
+    }
+}
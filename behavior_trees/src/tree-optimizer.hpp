@@ -0,0 +1,323 @@
+#pragma once
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include "simulation.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+
+// Offline tree optimizer. Turns a hand-written tree into an equivalent, cheaper one:
+//
+//   TreeGraph graph = TreeGraph::from(tree.root);
+//   const TreeProfile profile = record_profile(graph, workload);
+//   optimize(graph, profile);
+//   const BuiltTree fast = build(graph);
+//   const int diverged = verify_trace(tree.brain, fast.brain, workload); //-1: identical
+//
+// Every pass keeps the tree's behavior tick for tick:
+// * flatten: a Sequence directly inside a Sequence (a Selector inside a Selector) is spliced
+//   into its parent, and single-child Sequences and Selectors are replaced by their child.
+// * prune:   children that can never be reached are dropped: in a Selector everything after a
+//   child that never fails (e.g. RepeatForever), in a Sequence everything after one that never succeeds.
+// * reorder: runs of adjacent commutative conditions (see LeafTraits) are sorted by the expected
+//   cost of reaching a decision: cost / P(failure) in a Sequence, cost / P(success) in a Selector.
+//   Nothing else moves; actions and anything with side effects keep their hand-written order.
+//
+// Profiles are measured in the original order, so P(...) is conditional on the leaf being reached.
+// verify_trace() replays a seeded workload through both trees in lockstep and compares every agent
+// after every frame. Only ship an optimized tree it accepts.
+
+struct LeafStats final{
+    std::uint64_t calls = 0;
+    std::uint64_t successes = 0;
+    double ns = 0.0;  //total time spent in the leaf, timer overhead subtracted
+
+    double success_rate() const noexcept{ return calls ? static_cast<double>(successes) / static_cast<double>(calls) : 0.5; }
+    double cost_ns() const noexcept{ return calls ? std::max(ns / static_cast<double>(calls), 0.1) : 1.0; }
+};
+
+using TreeProfile = std::vector<LeafStats>; //indexed by TreeGraph vertex
+
+struct TreeGraph final{
+    struct Vertex final{
+        NodeKind kind = NodeKind::Opaque;
+        Node* source = nullptr;   //leaves keep their fn and traits; opaque nodes are reused as they are
+        int mem_slot = 0;         //MemorySequence
+        std::vector<int> children;
+    };
+    std::vector<Vertex> vertices;
+    int root = -1;
+
+    static TreeGraph from(Node& root){
+        TreeGraph g;
+        g.root = g.add(root);
+        return g;
+    }
+
+    const LeafTraits* traits(int v) const noexcept{
+        const Vertex& x = vertices[v];
+        return (x.kind == NodeKind::Leaf) ? &static_cast<const Leaf*>(x.source)->traits : nullptr;
+    }
+
+    // Statuses vertex `v` can return, derived bottom-up from the leaves' traits.
+    std::uint8_t outcomes(int v) const noexcept{
+        const Vertex& x = vertices[v];
+        const auto S = outcome(Status::Success), F = outcome(Status::Failure), R = outcome(Status::Running);
+        switch(x.kind){
+        case NodeKind::Leaf: return traits(v)->outcomes;
+        case NodeKind::RepeatForever: return R;
+        case NodeKind::Sequence:
+        case NodeKind::MemorySequence:
+        case NodeKind::Selector:{
+            const bool sequence = x.kind != NodeKind::Selector;
+            const std::uint8_t pass = sequence ? S : F;  //the status that moves on to the next child
+            std::uint8_t out = 0;
+            for(int c : x.children){
+                const std::uint8_t o = outcomes(c);
+                out |= o & ~pass;
+                if(!(o & pass)) return out; //control never gets past this child
+            }
+            return out | pass;
+        }
+        default: return any_outcome;
+        }
+    }
+
+    // One line per node, indented by depth.
+    std::string describe() const{
+        std::string out;
+        describe(root, 0, out);
+        return out;
+    }
+
+private:
+    int add(Node& n){
+        const int id = static_cast<int>(vertices.size());
+        Vertex& x = vertices.emplace_back();
+        x.kind = n.kind();
+        x.source = &n;
+        if(x.kind == NodeKind::MemorySequence){
+            x.mem_slot = static_cast<const MemorySequence&>(n).mem_slot;
+        }
+        for(Node* child : n.subtrees()){
+            const int c = add(*child);
+            vertices[id].children.push_back(c);
+        }
+        return id;
+    }
+
+    void describe(int v, int depth, std::string& out) const{
+        static constexpr const char* names[] = {"Leaf", "Sequence", "Selector", "MemorySequence", "RepeatForever", "Opaque"};
+        out.append(static_cast<std::size_t>(depth) * 2, ' ');
+        out += (vertices[v].kind == NodeKind::Leaf) ? traits(v)->name : names[static_cast<int>(vertices[v].kind)];
+        out += '\n';
+        for(int c : vertices[v].children){ describe(c, depth + 1, out); }
+    }
+};
+
+// --- Passes ---
+
+// A single-child Sequence or Selector returns exactly what its child returns.
+static int unwrap(const TreeGraph& g, int v) noexcept{
+    for(;;){
+        const auto& x = g.vertices[v];
+        if((x.kind != NodeKind::Sequence && x.kind != NodeKind::Selector) || x.children.size() != 1) return v;
+        v = x.children.front();
+    }
+}
+
+static void flatten(TreeGraph& g, int v) noexcept{
+    auto& x = g.vertices[v];
+    for(int c : x.children){ flatten(g, c); }
+    if(x.kind != NodeKind::Sequence && x.kind != NodeKind::Selector){
+        for(int& c : x.children){ c = unwrap(g, c); }
+        return;
+    }
+    std::vector<int> spliced;
+    for(int c : x.children){
+        const int inner = unwrap(g, c);
+        if(g.vertices[inner].kind == x.kind){
+            spliced.insert(spliced.end(), g.vertices[inner].children.begin(), g.vertices[inner].children.end());
+        } else{
+            spliced.push_back(inner);
+        }
+    }
+    x.children = std::move(spliced);
+}
+
+static void prune(TreeGraph& g, int v) noexcept{
+    auto& x = g.vertices[v];
+    if(x.kind == NodeKind::Sequence || x.kind == NodeKind::MemorySequence || x.kind == NodeKind::Selector){
+        const std::uint8_t pass = (x.kind == NodeKind::Selector) ? outcome(Status::Failure) : outcome(Status::Success);
+        for(std::size_t i = 0; i < x.children.size(); ++i){
+            if(!(g.outcomes(x.children[i]) & pass)){
+                x.children.resize(i + 1);
+                break;
+            }
+        }
+    }
+    for(int c : g.vertices[v].children){ prune(g, c); }
+}
+
+static void reorder(TreeGraph& g, int v, const TreeProfile& profile) noexcept{
+    auto& x = g.vertices[v];
+    for(int c : x.children){ reorder(g, c, profile); }
+    if(x.kind != NodeKind::Sequence && x.kind != NodeKind::Selector) return;
+    const bool sequence = x.kind == NodeKind::Sequence;
+    auto expected_cost = [&](int c){
+        const LeafStats& s = profile[c];
+        const double decides = sequence ? 1.0 - s.success_rate() : s.success_rate(); //chance this child ends the composite
+        return s.cost_ns() / std::max(decides, 1e-3);
+    };
+    auto commutative = [&](int c){ const auto* t = g.traits(c); return t && t->commutative; };
+    auto& kids = x.children;
+    for(auto first = kids.begin(); first != kids.end();){
+        if(!commutative(*first)){ ++first; continue; }
+        auto last = std::find_if_not(first, kids.end(), commutative);
+        std::stable_sort(first, last, [&](int a, int b){ return expected_cost(a) < expected_cost(b); });
+        first = last;
+    }
+}
+
+// flatten, then prune, then flatten again (pruning can leave single-child composites), then reorder.
+static void optimize(TreeGraph& g, const TreeProfile& profile) noexcept{
+    flatten(g, g.root);
+    prune(g, g.root);
+    flatten(g, g.root);
+    g.root = unwrap(g, g.root);
+    reorder(g, g.root, profile);
+}
+
+// --- Building ---
+
+// Counts and times every call of a leaf while profiling.
+struct ProfilingLeaf final : Node{
+    LeafFn fn{};
+    LeafStats* stats = nullptr;
+    double overhead_ns = 0.0;
+    ProfilingLeaf(LeafFn f, LeafStats& s, double overhead) : fn(f), stats(&s), overhead_ns(overhead){}
+
+    Status tick(Context& ctx, float dt) const noexcept override{
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        const Status s = fn(ctx, dt);
+        stats->ns += std::chrono::duration<double, std::nano>(clock::now() - start).count() - overhead_ns;
+        ++stats->calls;
+        stats->successes += (s == Status::Success) ? 1 : 0;
+        return s;
+    }
+};
+
+// A tree instantiated from a graph. Owns its composites and leaves; opaque nodes are borrowed.
+struct BuiltTree final{
+    std::vector<std::unique_ptr<Node>> nodes;
+    EntityBrain brain;
+};
+
+namespace detail{
+    inline Node* instantiate(const TreeGraph& g, int v, BuiltTree& out, TreeProfile* profile, double overhead){
+        const auto& x = g.vertices[v];
+        std::vector<Node*> kids;
+        for(int c : x.children){ kids.push_back(instantiate(g, c, out, profile, overhead)); }
+        std::unique_ptr<Node> n;
+        switch(x.kind){
+        case NodeKind::Leaf:{
+            const auto* leaf = static_cast<const Leaf*>(x.source);
+            if(profile){ n = std::make_unique<ProfilingLeaf>(leaf->fn, (*profile)[v], overhead); }
+            else{ n = std::make_unique<Leaf>(leaf->fn, leaf->traits, leaf->batch); }
+            break;
+        }
+        case NodeKind::Sequence: n = std::make_unique<Sequence>(std::move(kids)); break;
+        case NodeKind::Selector: n = std::make_unique<Selector>(std::move(kids)); break;
+        case NodeKind::MemorySequence: n = std::make_unique<MemorySequence>(x.mem_slot, std::move(kids)); break;
+        case NodeKind::RepeatForever: n = std::make_unique<RepeatForever>(kids.front()); break;
+        default: return x.source;
+        }
+        out.nodes.push_back(std::move(n));
+        return out.nodes.back().get();
+    }
+}
+
+// Instantiates the graph. With `profile`, leaves are wrapped to record into it.
+static BuiltTree build(const TreeGraph& g, TreeProfile* profile = nullptr){
+    double overhead = 0.0;
+    if(profile){
+        profile->assign(g.vertices.size(), LeafStats{});
+        using clock = std::chrono::steady_clock;
+        constexpr int samples = 1000;
+        const auto start = clock::now();
+        for(int i = 0; i < samples; ++i){ std::ignore = clock::now(); }
+        overhead = std::chrono::duration<double, std::nano>(clock::now() - start).count() / samples;
+    }
+    BuiltTree out;
+    out.brain.root = detail::instantiate(g, g.root, out, profile, overhead);
+    return out;
+}
+
+// --- Workloads ---
+
+// A reproducible run: the same seed always spawns the same agents and the same world.
+struct Workload final{
+    Blackboard board;           //an empty blackboard with the tree's keys
+    std::uint64_t seed = 1;
+    std::size_t agents = 2'000;
+    int frames = 1'200;
+    int wolf_period = 400;      //toggle the wolf every N frames, so every branch gets exercised
+    float dt = 1.0f / 60.0f;
+};
+
+struct Replay final{
+    World world;
+    EntityPool population;
+    const Workload* workload = nullptr;
+    int frame = 0;
+
+    explicit Replay(const Workload& w) : population(w.board), workload(&w){
+        Rng rng{w.seed};
+        population.spawn(w.agents, rng);
+        world.rng = Rng{w.seed, 1};
+    }
+
+    void step(const EntityBrain& brain) noexcept{
+        if(workload->wolf_period > 0 && frame > 0 && frame % workload->wolf_period == 0){
+            world.set_wolf_active(!world.wolf_active);
+        }
+        simulate(world, brain, population, workload->dt);
+        ++frame;
+    }
+};
+
+static TreeProfile record_profile(const TreeGraph& g, const Workload& w){
+    TreeProfile profile;
+    const BuiltTree profiled = build(g, &profile);
+    Replay replay(w);
+    for(int f = 0; f < w.frames; ++f){ replay.step(profiled.brain); }
+    return profile;
+}
+
+// Runs both brains on the workload in lockstep. Returns the first frame after which any
+// agent differs (decision, physics, BT memory) or the world does, or -1 if the traces are identical.
+static int verify_trace(const EntityBrain& a, const EntityBrain& b, const Workload& w){
+    Replay ra(w), rb(w);
+    auto same_pos = [](Vector2 x, Vector2 y){ return x.x == y.x && x.y == y.y; }; //bit-exact, unlike Vector2Equals
+    auto same = [&](const Entity& x, const Entity& y){
+        return x.activity == y.activity && same_pos(x.position, y.position) && same_pos(x.velocity, y.velocity);
+    };
+    auto same_hunger = [](const Blackboard& x, const Blackboard& y, std::size_t i){
+        if(!x.has<Hunger>() || !y.has<Hunger>()) return x.has<Hunger>() == y.has<Hunger>();
+        const LinearStat& hx = x.get<Hunger>(i);
+        const LinearStat& hy = y.get<Hunger>(i);
+        return hx.value == hy.value && hx.stamp == hy.stamp;
+    };
+    for(int f = 0; f < w.frames; ++f){
+        ra.step(a);
+        rb.step(b);
+        if(ra.world.food_serial != rb.world.food_serial || !same_pos(ra.world.food_pos, rb.world.food_pos)) return f;
+        const auto ea = ra.population.entities(), eb = rb.population.entities();
+        const auto ma = ra.population.memory(), mb = rb.population.memory();
+        for(std::size_t i = 0; i < ea.size(); ++i){
+            if(!same(ea[i], eb[i]) || ma[i].bt_mem != mb[i].bt_mem || !same_hunger(ra.population.board(), rb.population.board(), i)) return f;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "common.hpp"
+#include "entity.hpp"
+
+// The constants the DemoTree leaves decide and steer with. Every World carries its own copy
+// (world.tuning), so a batch can run each instance with different values; see sweep.hpp.
+// Set them before a run: cached subtrees (subtree-cache.hpp) do not notice a change.
+struct Tuning final{
+    float threat_radius = 180.0f;  //ThreatNearby; keep it within World::danger_radius so flee directions are routed
+    float hunger_on = 0.95f;       //IsHungry is raised when hunger reaches this; eating clears it
+    float patrol_speed = 0.65f;    //fraction of Entity::max_speed
+    float seek_speed = 0.7f;       //fraction of Entity::max_speed
+    float flee_weight = Entity::flee_weight;
+    float separation_weight = 0.5f; //flocking.hpp, between all agents after the tree has steered; 0 = off
+    float alignment_weight = 0.0f;
+    float cohesion_weight = 0.0f;
+};
+
+// Name and search range of every Tuning field, for sweeps and for printing results.
+struct TuningParam final{
+    const char* name;
+    float Tuning::* field;
+    float min;
+    float max;
+};
+
+constexpr std::array<TuningParam, 8> tuning_params{{
+    {"threat_radius", &Tuning::threat_radius, 60.0f, 240.0f},
+    {"hunger_on", &Tuning::hunger_on, 0.5f, 1.0f},
+    {"patrol_speed", &Tuning::patrol_speed, 0.2f, 1.0f},
+    {"seek_speed", &Tuning::seek_speed, 0.2f, 1.0f},
+    {"flee_weight", &Tuning::flee_weight, 0.2f, 3.0f},
+    {"separation_weight", &Tuning::separation_weight, 0.0f, 2.0f},
+    {"alignment_weight", &Tuning::alignment_weight, 0.0f, 2.0f},
+    {"cohesion_weight", &Tuning::cohesion_weight, 0.0f, 2.0f},
+}};
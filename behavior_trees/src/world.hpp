@@ -1,14 +1,60 @@
 #pragma once
 #include "common.hpp"
+#include "flow-field.hpp"
+#include "tuning.hpp"
+
+// World fields a cached subtree may depend on (see subtree-cache.hpp).
+// World's own methods stamp them with the frame they were written in;
+// writing the public fields directly bypasses that.
+enum class WorldInput : std::uint8_t{ WolfPosition, WolfActive, FoodPosition, Obstacles, Count };
+
+// World writes requested by leaves while the population is being ticked, applied afterwards
+// in agent order (apply_commands in game-ai.hpp). Keeps the tick free of shared writes, so
+// the population can be ticked in chunks on several threads with the same result.
+// Only the lowest row that reached the food is kept, as only it eats: a fixed size, so
+// recording a write never allocates.
+struct WorldCommands final{
+    static constexpr std::uint32_t nobody = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t food_reached = nobody; //lowest row of the agents that reached the food this frame
+
+    void reach_food(std::size_t row) noexcept{ food_reached = std::min(food_reached, static_cast<std::uint32_t>(row)); }
+    void clear() noexcept{ food_reached = nobody; }
+};
+
+// The part of the World the renderer draws, as plain values. Lets a frame be drawn
+// while the simulation is already advancing the World itself (frame-pipeline.hpp).
+struct WorldView final{
+    Vector2 food_pos = ZERO;
+    Vector2 wolf_pos = ZERO;
+    bool wolf_active = false;
+    std::array<Vector2, 4> waypoints{};
+    std::vector<std::uint8_t> blocked; //FlowGrid::blocked
+    int obstacle_count = 0;
+    std::uint32_t grid_version = 0;
+
+    void render() const noexcept;
+};
 
 struct World final{
     static constexpr float margin = ENTITY_SIZE * 10;
     static constexpr float waypoint_radius = 18.0f;
     static constexpr float food_radius = 16.0f;
+    static constexpr float catch_radius = 20.0f; //an agent this close to the active wolf counts as caught (batch statistics)
 
     Vector2 food_pos = {STAGE_WIDTH * 0.25f, STAGE_HEIGHT * 0.5f};
     Vector2 wolf_pos = {STAGE_WIDTH * 0.75f, STAGE_HEIGHT * 0.5f};
     bool wolf_active = true;
+    std::uint32_t threat_epoch = 0; //bumped whenever the wolf appears, disappears or jumps; see ThreatSafeUntil
+    std::uint32_t frame = 0; //number of update() calls so far
+    std::uint32_t resort_period = 30; //frames between Morton re-sorts of the population (resort() in simulation.hpp); 0 = never
+    float time = 0.0f;       //seconds simulated so far; the clock of LinearStat and TimerQueue
+    std::uint32_t food_serial = 0; //bumped every time the food moves
+    float wolf_time = 0.0f;
+    Vector2 wolf_offset = ZERO; //from place_wolf(), added to the wolf's path
+    Rng rng; //everything random in the world draws from here, so a seeded world replays exactly
+    std::array<std::uint32_t, static_cast<std::size_t>(WorldInput::Count)> written{}; //frame of the last write, per WorldInput
+    WorldCommands commands; //simulate()'s buffer; threaded runs keep one per chunk
+    Tuning tuning;          //the leaves' constants for this world
     
     std::array<Vector2, 4> waypoints{
         Vector2{margin, margin},
@@ -17,31 +63,112 @@ struct World final{
         Vector2{margin, STAGE_HEIGHT - margin}
     };
 
+    // The wolf's path: a Lissajous curve around the stage center, shifted by wolf_offset.
+    static constexpr Vector2 wolf_center{STAGE_WIDTH * 0.5f, STAGE_HEIGHT * 0.5f};
+    static constexpr Vector2 wolf_rate{0.7f, 1.1f};   //radians per second, per axis
+    static constexpr Vector2 wolf_range{STAGE_WIDTH * 0.28f, STAGE_HEIGHT * 0.22f};
+    static constexpr float wolf_max_speed = wolf_rate.x * wolf_range.x + wolf_rate.y * wolf_range.y; //bound on |d wolf_pos / dt|
+
+    // navigation: one shared flow field per goal, sampled by every agent.
+    // The wolf's danger field only needs to cover a bit more than the flee radius.
+    static constexpr float danger_radius = 240.0f;
+    static constexpr int flow_budget = FlowGrid::cell_count / 4; //cells each field may settle per frame
+    FlowGrid grid;
+    FlowField food_field;
+    FlowField wolf_field{danger_radius};
+    std::array<FlowField, 4> waypoint_fields{};
+
+    World() noexcept{
+        food_field.set_goal(grid, food_pos);
+        wolf_field.set_goal(grid, wolf_pos);
+        for(std::size_t i = 0; i < waypoints.size(); ++i){
+            waypoint_fields[i].set_goal(grid, waypoints[i]);
+        }
+    }
+
     void respawn_food() noexcept{
-        food_pos = random_range(ZERO, STAGE_SIZE);
-    }        
+        food_pos = rng.range(ZERO, STAGE_SIZE);
+        ++food_serial;
+        touch(WorldInput::FoodPosition);
+        food_field.set_goal(grid, food_pos);
+    }
+
+    void add_obstacle(Rectangle r) noexcept{
+        grid.block(r); //fields notice the new grid version and rebuild in update()
+        touch(WorldInput::Obstacles);
+    }
+
+    void set_wolf_active(bool active) noexcept{
+        if(active == wolf_active) return;
+        wolf_active = active;
+        ++threat_epoch;
+        touch(WorldInput::WolfActive);
+    }
+
+    // Moves the wolf to `pos` at once; it carries on along its path from there.
+    void place_wolf(Vector2 pos) noexcept{
+        wolf_offset += pos - wolf_pos;
+        wolf_pos = pos;
+        ++threat_epoch;
+        touch(WorldInput::WolfPosition);
+        wolf_field.set_goal(grid, wolf_pos);
+    }
+
+    void touch(WorldInput input) noexcept{
+        written[static_cast<std::size_t>(input)] = frame;
+    }
 
     void update(float dt) noexcept{
+        ++frame;
+        time += dt;
+        update_wolf(dt);
+        wolf_field.set_goal(grid, wolf_pos);
+        std::ignore = food_field.update(grid, flow_budget);
+        std::ignore = wolf_field.update(grid, flow_budget);
+        for(auto& field : waypoint_fields){
+            std::ignore = field.update(grid, flow_budget);
+        }
+    }
+
+    void update_wolf(float dt) noexcept{
         if(!wolf_active){ return; }
-        static float t = 0.0f;
-        t += dt;
-        static constexpr Vector2 center{STAGE_WIDTH * 0.5f, STAGE_HEIGHT * 0.5f}; //origin of the motion        
-        static constexpr Vector2 speed{0.7f, 1.1f};
-        static constexpr Vector2 range{(STAGE_WIDTH * 0.28f), (STAGE_HEIGHT * 0.22f)}; //amplitude of the motion                        
-        wolf_pos.x = center.x + std::cos(t * speed.x) * range.x;
-        wolf_pos.y = center.y + std::sin(t * speed.y) * range.y;
-    }
-
-    void render() const noexcept{
-        auto i = 0;
-        for(auto node : waypoints){
-            DrawCircleV(node, 6.0f, DARKGREEN);
-            DrawText(TextFormat("%d", i++), node.x + 8.0f, node.y - 8.0f, FONT_SIZE, DARKGREEN);
+        wolf_time += dt;
+        touch(WorldInput::WolfPosition);
+        const float t = wolf_time;
+        wolf_pos.x = wolf_center.x + wolf_offset.x + std::cos(t * wolf_rate.x) * wolf_range.x;
+        wolf_pos.y = wolf_center.y + wolf_offset.y + std::sin(t * wolf_rate.y) * wolf_range.y;
+    }
+
+    // Copies what render() needs; the obstacle cells only when they changed since the last capture.
+    void capture(WorldView& out) const{
+        out.food_pos = food_pos;
+        out.wolf_pos = wolf_pos;
+        out.wolf_active = wolf_active;
+        out.waypoints = waypoints;
+        if(out.grid_version != grid.version || out.blocked.empty()){
+            out.blocked = grid.blocked;
+            out.obstacle_count = grid.obstacle_count;
+            out.grid_version = grid.version;
         }
-        DrawCircleV(food_pos, food_radius, GOLD);
-        if(wolf_active){ 
-            DrawCircleV(wolf_pos, 14.0f, RED); 
+    }
+};
+
+inline void WorldView::render() const noexcept{
+    if(obstacle_count > 0){
+        for(int cell = 0; cell < FlowGrid::cell_count; ++cell){
+            if(!blocked[cell]) continue;
+            const Vector2 p = FlowGrid::center_of(cell) - Vector2{FlowGrid::cell_size, FlowGrid::cell_size} * 0.5f;
+            DrawRectangleV(p, {FlowGrid::cell_size, FlowGrid::cell_size}, LIGHTGRAY);
         }
-        DrawText("F = toggle wolf", 10, 10, FONT_SIZE, DARKGRAY);
     }
-};
\ No newline at end of file
+    auto i = 0;
+    for(auto node : waypoints){
+        DrawCircleV(node, 6.0f, DARKGREEN);
+        DrawText(TextFormat("%d", i++), node.x + 8.0f, node.y - 8.0f, FONT_SIZE, DARKGREEN);
+    }
+    DrawCircleV(food_pos, World::food_radius, GOLD);
+    if(wolf_active){ 
+        DrawCircleV(wolf_pos, 14.0f, RED); 
+    }
+    DrawText("F = toggle wolf, W = wolf to cursor", 10, 10, FONT_SIZE, DARKGRAY);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts calls to the global operator new, so a benchmark can check that a loop does not allocate.
+//
+// Replaces the global allocation functions (the array and nothrow forms forward to these), so it
+// must be included by exactly one translation unit: the benchmarks are one, main.cpp. The count
+// is one relaxed atomic add per allocation, on every thread.
+
+inline std::atomic<std::uint64_t> heap_allocations{0};
+
+inline std::uint64_t allocations() noexcept{ return heap_allocations.load(std::memory_order_relaxed); }
+
+void* operator new(std::size_t bytes){
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(bytes != 0 ? bytes : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t bytes, std::align_val_t align){
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto a = static_cast<std::size_t>(align);
+#ifdef _MSC_VER
+    if(void* p = _aligned_malloc(bytes != 0 ? bytes : 1, a)) return p;
+#else
+    if(void* p = std::aligned_alloc(a, bytes != 0 ? (bytes + a - 1) / a * a : a)) return p; //a non-zero multiple of the alignment
+#endif
+    throw std::bad_alloc{};
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" //these deletes inlined next to a call to the new above look mismatched to GCC
+#endif
+void operator delete(void* p) noexcept{ std::free(p); }
+void operator delete(void* p, std::size_t) noexcept{ std::free(p); }
+#ifdef _MSC_VER
+void operator delete(void* p, std::align_val_t) noexcept{ _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept{ _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept{ std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept{ std::free(p); }
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
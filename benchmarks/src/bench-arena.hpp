@@ -0,0 +1,121 @@
+#pragma once
+#include "bench.hpp"
+#include "alloc-counter.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "frame-arena.hpp"
+#include "frame-graph.hpp"
+#include "frame-pipeline.hpp"
+#include "job-system.hpp"
+#include "batch-tree.hpp"
+#include "bucketed-brain.hpp"
+#include "decision-table.hpp"
+#include "far-field.hpp"
+#include "squad.hpp"
+
+// The steady-state frame must not touch the heap. Every way of stepping the simulation runs
+// `warmup` frames first (containers reach their high-water capacity, each thread's frame arena
+// settles on one block), then `frames` more with operator new counted around each one. Any
+// allocation fails the benchmark; the first frame that allocated is named. Transient data goes
+// to the frame arenas (frame-arena.hpp) instead; the calling thread's use of its own is shown.
+static int bench_arena(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 20'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const int warmup = static_cast<int>(arg_or(args, "warmup", 120));
+    const auto threads = static_cast<std::size_t>(arg_or(args, "threads", std::max(2u, std::thread::hardware_concurrency())));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    std::printf("arena: %zu agents, %d warm-up frames, then %d frames with operator new counted\n", count, warmup, frames);
+    // Runs step() warmup + frames times; counts the allocations of the frames after the warm-up.
+    auto check = [&](const char* name, auto&& step){
+        std::uint64_t calls = 0;
+        int allocating = 0, first = -1;
+        double ns = 0.0;
+        for(int f = 0; f < warmup; ++f){ step(); }
+        for(int f = 0; f < frames; ++f){
+            const std::uint64_t before = allocations();
+            ns += time_ns(step);
+            const std::uint64_t made = allocations() - before;
+            if(made == 0) continue;
+            calls += made;
+            ++allocating;
+            if(first < 0){ first = warmup + f; }
+        }
+        std::printf("  %-28s %8.2f ns/agent frame  %6llu operator new in %4d frames", name,
+            ns / (static_cast<double>(count) * frames), static_cast<unsigned long long>(calls), allocating);
+        if(first >= 0){ std::printf("  (first at frame %d)", first); }
+        std::printf("\n");
+        failures += (calls == 0) ? 0 : 1;
+    };
+
+    struct Run final{
+        World world;
+        EntityPool pool;
+        Run(Blackboard board, std::size_t count) : pool(std::move(board)){
+            world.rng = Rng{9};
+            Rng rng{3};
+            pool.spawn(count, rng);
+        }
+    };
+    DemoTree tree;
+    {
+        Run r{Blackboard{DemoTree::Keys{}}, count};
+        check("simulate()", [&]{ simulate(r.world, tree.brain, r.pool, dt); });
+    }
+    {
+        Run r{Blackboard{BucketedBrain::Keys<DemoTree::Keys>{}}, count};
+        BucketedBrain brain{tree.root};
+        check("BucketedBrain", [&]{ simulate(r.world, brain, r.pool, dt); });
+    }
+    {
+        Run r{Blackboard{DemoTree::Keys{}}, count};
+        DecisionTable table{tree.root, demo_batch_conditions};
+        check("DecisionTable", [&]{ simulate(r.world, table, r.pool, dt); });
+    }
+    {
+        Run r{Blackboard{DemoTree::Keys{}}, count};
+        BatchTree batch{tree.root};
+        check("BatchTree", [&]{ simulate(r.world, batch, r.pool, dt); });
+    }
+    {
+        Run r{Blackboard{FarField::Keys{}}, count};
+        FarField far;
+        check("FarField", [&]{ simulate(r.world, tree.brain, far, r.pool, dt); });
+    }
+    {
+        Run r{Blackboard{MemberTree::Keys{}}, count};
+        SquadTree squad_tree;
+        MemberTree member_tree;
+        Squads squads;
+        check("Squads", [&]{ simulate(r.world, squads, squad_tree.brain, member_tree.brain, r.pool, dt); });
+    }
+    for(const std::size_t n : {std::size_t{1}, threads}){
+        Run r{Blackboard{DemoTree::Keys{}}, count};
+        JobSystem jobs{n};
+        SimulationGraph graph{r.world, tree.brain, r.pool};
+        RenderSnapshot snapshot;
+        char name[40];
+        std::snprintf(name, sizeof(name), "SimulationGraph, %zu thread%s", n, n == 1 ? "" : "s");
+        check(name, [&]{ graph.step(jobs, dt, &snapshot); });
+    }
+    {
+        Run r{Blackboard{DemoTree::Keys{}}, count};
+        FrameWorker worker;
+        RenderSnapshot snapshot;
+        check("FrameWorker + simulate()", [&]{ //as the demo's loop, without the drawing
+            worker.kick([&r, &tree, &snapshot, dt]{
+                simulate(r.world, tree.brain, r.pool, dt);
+                snapshot.capture(r.world, r.pool);
+            });
+            worker.wait();
+        });
+    }
+
+    const FrameArena& arena = frame_arena();
+    std::printf("  frame arena of this thread: high water %.1f KiB, %zu block of %.1f KiB\n",
+        arena.high_water() / 1024.0, arena.blocks(), arena.capacity() / 1024.0);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (the steady-state frame allocated)");
+    return failures;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "batch-tree.hpp"
+
+// DemoTree ticked agent by agent (EntityBrain) vs node by node (BatchTree), with the leaves that
+// have a batch form called once per node on all the rows that reach it. The two runs go in
+// lockstep and must stay identical. After the run, each batched leaf on its own: called per row
+// through its LeafFn vs once through its BatchLeafFn, on every row of the population.
+static int bench_batch_leaves(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    };
+    auto make = [&]{
+        Run r;
+        r.world.rng = Rng{9};
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        return r;
+    };
+    DemoTree tree;
+    BatchTree batched{tree.root};
+    Run plain = make();
+    Run rows = make();
+
+    // simulate() with the tick timed on its own, like bench-buckets
+    auto integrate = [&](Run& r, bool flocking){
+        auto entities = r.pool.entities();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            if(flocking){ flock(r.pool.neighbors(), entities[i], i); }
+            entities[i].update(dt);
+        }
+        apply_commands(r.world, r.pool, {&r.world.commands, 1});
+    };
+    double plain_ns = 0.0, batch_ns = 0.0;
+    std::size_t batch_calls = 0, scalar_calls = 0;
+    for(int f = 0; f < frames; ++f){
+        bool flocking = prepare_step(plain.world, plain.pool, dt);
+        plain_ns += time_ns([&]{
+            auto entities = plain.pool.entities();
+            auto memory = plain.pool.memory();
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], plain.world, plain.pool.board(), plain.pool.senses(), i, &plain.world.commands};
+                std::ignore = tree.brain.tick(ctx, dt);
+            }
+        });
+        integrate(plain, flocking);
+
+        flocking = prepare_step(rows.world, rows.pool, dt);
+        batch_ns += time_ns([&]{ batched.tick(rows.world, rows.pool, &rows.world.commands, dt); });
+        batch_calls += batched.batch_calls();
+        scalar_calls += batched.scalar_calls();
+        integrate(rows, flocking);
+
+        const auto a = plain.pool.entities(), b = rows.pool.entities();
+        for(std::size_t i = 0; i < count; ++i){
+            failures += (a[i].activity == b[i].activity && a[i].position.x == b[i].position.x && a[i].position.y == b[i].position.y) ? 0 : 1;
+        }
+        if(failures > 0){
+            std::printf("  runs diverge at frame %d\n", f);
+            break;
+        }
+    }
+
+    const double agent_frames = static_cast<double>(count) * frames;
+    std::printf("leaves: %zu agents x %d frames, DemoTree\n", count, frames);
+    std::printf("  %-22s %8.2f ns/agent tick\n", "EntityBrain", plain_ns / agent_frames);
+    std::printf("  %-22s %8.2f ns/agent tick  (%.1f batch calls, %.1f per-row calls per frame)\n", "BatchTree", batch_ns / agent_frames,
+        static_cast<double>(batch_calls) / frames, static_cast<double>(scalar_calls) / frames);
+
+    // the leaves on their own, on the last frame's population
+    std::vector<std::uint32_t> all(count);
+    for(std::size_t i = 0; i < count; ++i){ all[i] = static_cast<std::uint32_t>(i); }
+    std::vector<Status> out(count);
+    auto& r = rows;
+    BatchContext bctx{r.world, r.pool.entities(), r.pool.memory(), r.pool.board(), r.pool.senses(), &r.world.commands};
+    const Leaf* leaves[] = {&tree.threat, &tree.flee, &tree.moveToCorner, &tree.hungry, &tree.seekFood};
+    const char* names[] = {"ThreatNearby", "DoFlee", "MoveToCorner", "CheckHunger", "DoSeekFood"};
+    std::printf("  %-22s %10s %10s\n", "leaf, every row", "per row", "batch");
+    for(std::size_t k = 0; k < std::size(leaves); ++k){
+        const Leaf& leaf = *leaves[k];
+        const double scalar = best_time_ns(5, [&]{
+            for(std::size_t i = 0; i < count; ++i){
+                Context c = bctx.at(i);
+                out[i] = leaf.fn(c, dt);
+            }
+            r.world.commands.clear();
+        });
+        const double batch = best_time_ns(5, [&]{
+            leaf.batch(bctx, all, out, dt);
+            r.world.commands.clear();
+        });
+        std::printf("  %-22s %7.2f ns %7.2f ns\n", names[k], scalar / count, batch / count);
+    }
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (BatchTree changed the result)");
+    return failures;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "bench.hpp"
+#include "batch-runner.hpp"
+
+// Throughput of many independent world+population instances on 1..N threads, the aggregate
+// statistics, and a check that every instance's result is the same on any thread count.
+static int bench_batch(Args args){
+    BatchConfig config;
+    config.instances = static_cast<std::size_t>(arg_or(args, "instances", 256));
+    config.agents = static_cast<std::size_t>(arg_or(args, "agents", 100));
+    config.frames = static_cast<int>(arg_or(args, "frames", 600));
+    config.seed = static_cast<std::uint64_t>(arg_or(args, "seed", 1));
+    const auto max_threads = static_cast<std::size_t>(arg_or(args, "threads", std::max(1u, std::thread::hardware_concurrency())));
+    DemoTree tree;
+    int failures = 0;
+
+    auto same = [](const InstanceStats& a, const InstanceStats& b){
+        return a.seed == b.seed && a.food_eaten == b.food_eaten && a.flee_seconds == b.flee_seconds
+            && a.seek_food_seconds == b.seek_food_seconds && a.patrol_seconds == b.patrol_seconds;
+    };
+
+    const double agent_frames = static_cast<double>(config.instances) * config.agents * config.frames;
+    std::printf("batch: %zu instances x %zu agents x %d frames\n", config.instances, config.agents, config.frames);
+    BatchStats first;
+    for(std::size_t threads = 1; threads <= max_threads; threads *= 2){
+        JobSystem jobs{threads};
+        const BatchStats stats = run_batch(jobs, tree.brain, config);
+        if(threads == 1){ first = stats; }
+        for(std::size_t i = 0; i < config.instances; ++i){
+            failures += same(first.instances[i], stats.instances[i]) ? 0 : 1;
+        }
+        std::printf("  %3zu threads  %9.1f ms  %8.2f M agent-frames/s\n", threads, stats.wall_ns / 1e6, agent_frames / stats.wall_ns * 1000.0);
+    }
+
+    auto print = [&](const char* label, BatchStats::Summary s, double scale, const char* unit){
+        std::printf("  %-18s mean %7.2f%s  min %7.2f%s  max %7.2f%s\n", label, s.mean * scale, unit, s.min * scale, unit, s.max * scale, unit);
+    };
+    print("time fleeing", first.summarize(BatchStats::fraction(&InstanceStats::flee_seconds)), 100.0, "%");
+    print("time seeking food", first.summarize(BatchStats::fraction(&InstanceStats::seek_food_seconds)), 100.0, "%");
+    print("time patrolling", first.summarize(BatchStats::fraction(&InstanceStats::patrol_seconds)), 100.0, "%");
+    print("food eaten", first.summarize([](const InstanceStats& i){ return static_cast<double>(i.food_eaten); }), 1.0, "");
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (results depend on the thread count)");
+    return failures;
+}
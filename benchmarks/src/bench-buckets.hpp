@@ -0,0 +1,107 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "bucketed-brain.hpp"
+
+// DemoTree ticked in row order vs by BucketedBrain, grouped by last frame's branch. The two runs
+// go in lockstep and must stay identical. Without hardware counters, "switches" stands in for
+// branch misses: how often an agent takes a different root branch than the agent ticked right
+// before it, which is when the guards' and the dispatch's branch history stops predicting.
+static int bench_buckets(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const auto resort = static_cast<std::uint32_t>(arg_or(args, "resort", World{}.resort_period));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{BucketedBrain::Keys<DemoTree::Keys>{}}};
+    };
+    auto make = [&]{
+        Run r;
+        r.world.rng = Rng{9};
+        r.world.resort_period = resort;
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        return r;
+    };
+    DemoTree tree;
+    BucketedBrain bucketed{tree.root};
+    Run plain = make();
+    Run grouped = make();
+
+    // simulate() with the tick timed on its own
+    auto step_plain = [&](Run& r){
+        const bool flocking = prepare_step(r.world, r.pool, dt);
+        auto entities = r.pool.entities();
+        auto memory = r.pool.memory();
+        const double ns = time_ns([&]{
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], r.world, r.pool.board(), r.pool.senses(), i, &r.world.commands};
+                std::ignore = tree.brain.tick(ctx, dt);
+            }
+        });
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            if(flocking){ flock(r.pool.neighbors(), entities[i], i); }
+            entities[i].update(dt);
+        }
+        apply_commands(r.world, r.pool, {&r.world.commands, 1});
+        return ns;
+    };
+    auto step_grouped = [&](Run& r){
+        const bool flocking = prepare_step(r.world, r.pool, dt);
+        const double ns = time_ns([&]{ bucketed.tick(r.world, r.pool, &r.world.commands, dt); });
+        auto entities = r.pool.entities();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            if(flocking){ flock(r.pool.neighbors(), entities[i], i); }
+            entities[i].update(dt);
+        }
+        apply_commands(r.world, r.pool, {&r.world.commands, 1});
+        return ns;
+    };
+
+    double plain_ns = 0.0, grouped_ns = 0.0;
+    std::size_t row_switches = 0, bucket_switches = 0, changes = 0;
+    std::vector<std::uint8_t> before;
+    std::vector<std::uint32_t> order;
+    for(int f = 0; f < frames; ++f){
+        const auto prev = grouped.pool.board().column<ActiveBranch>();
+        before.assign(prev.begin(), prev.end()); //grouped order = rows stably sorted by this
+        plain_ns += step_plain(plain);
+        grouped_ns += step_grouped(grouped);
+        changes += bucketed.last_changes();
+
+        const auto now = grouped.pool.board().column<ActiveBranch>();
+        order.resize(now.size());
+        for(std::size_t i = 0; i < order.size(); ++i){ order[i] = static_cast<std::uint32_t>(i); }
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b){ return before[a] < before[b]; });
+        for(std::size_t i = 1; i < now.size(); ++i){
+            row_switches += (now[i] != now[i - 1]) ? 1 : 0;
+            bucket_switches += (now[order[i]] != now[order[i - 1]]) ? 1 : 0;
+        }
+
+        const auto a = plain.pool.entities(), b = grouped.pool.entities();
+        for(std::size_t i = 0; i < count; ++i){
+            failures += (a[i].activity == b[i].activity && a[i].position.x == b[i].position.x && a[i].position.y == b[i].position.y) ? 0 : 1;
+        }
+        if(failures > 0){
+            std::printf("  runs diverge at frame %d\n", f);
+            break;
+        }
+    }
+
+    const auto sizes = bucketed.bucket_sizes();
+    const double agent_frames = static_cast<double>(count) * frames;
+    std::printf("buckets: %zu agents x %d frames, DemoTree, Morton re-sort every %u frames (0 = never)\n", count, frames, resort);
+    std::printf("  last frame's buckets:");
+    for(std::size_t b = 0; b < sizes.size(); ++b){ std::printf(" %u", sizes[b]); }
+    std::printf("  (root branches in order, then none)\n");
+    std::printf("  agents changing branch   %6.3f %% per frame\n", 100.0 * changes / agent_frames);
+    std::printf("  %-22s %8.2f ns/agent tick  %6.2f %% switches\n", "row order", plain_ns / agent_frames, 100.0 * row_switches / agent_frames);
+    std::printf("  %-22s %8.2f ns/agent tick  %6.2f %% switches\n", "BucketedBrain", grouped_ns / agent_frames, 100.0 * bucket_switches / agent_frames);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (bucketed tick changed the result)");
+    return failures;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "bench.hpp"
+#include "game-ai.hpp"
+#include "subtree-cache.hpp"
+
+// A condition-dominated tree: deciding takes several line-of-sight walks over the grid,
+// acting is a single store. The conditions only depend on things that rarely change.
+static Status IsHungryFlag(Context& ctx, float) noexcept{
+    return ctx.get<IsHungry>() ? Status::Success : Status::Failure;
+}
+
+static Status FoodVisible(Context& ctx, float) noexcept{ //from the agent's current waypoint
+    const auto& grid = ctx.world.grid;
+    const int from = FlowGrid::cell_of(ctx.world.waypoints[ctx.get<WaypointIndex>()]);
+    return grid.line_of_sight(from, FlowGrid::cell_of(ctx.world.food_pos)) ? Status::Success : Status::Failure;
+}
+
+static Status WolfAway(Context& ctx, float) noexcept{
+    return ctx.world.wolf_active ? Status::Failure : Status::Success;
+}
+
+static Status RouteClear(Context& ctx, float) noexcept{ //every leg of the patrol route is unobstructed
+    const auto& w = ctx.world;
+    for(std::size_t i = 0; i < w.waypoints.size(); ++i){
+        const int a = FlowGrid::cell_of(w.waypoints[i]);
+        const int b = FlowGrid::cell_of(w.waypoints[(i + 1) % w.waypoints.size()]);
+        if(!w.grid.line_of_sight(a, b)) return Status::Failure;
+    }
+    return Status::Success;
+}
+
+static Status MarkPlanned(Context& ctx, float) noexcept{
+    ctx.self.activity = Activity::Patrol;
+    return Status::Running;
+}
+
+static Status MarkIdle(Context& ctx, float) noexcept{
+    ctx.self.activity = Activity::None;
+    return Status::Running;
+}
+
+struct ConditionTree final{
+    Leaf hungry{IsHungryFlag, condition("IsHungry", reads_key<IsHungry>)};
+    Leaf foodVisible{FoodVisible, condition("FoodVisible", reads_key<WaypointIndex> | reads_world(WorldInput::FoodPosition) | reads_world(WorldInput::Obstacles))};
+    Sequence forage{&hungry, &foodVisible};
+    Leaf wolfAway{WolfAway, condition("WolfAway", reads_world(WorldInput::WolfActive))};
+    Leaf routeClear{RouteClear, condition("RouteClear", reads_world(WorldInput::Obstacles))};
+    Sequence patrol{&wolfAway, &routeClear};
+    Selector plan{&forage, &patrol};
+
+    Leaf planned{MarkPlanned, action("MarkPlanned", outcome(Status::Running))};
+    Leaf idle{MarkIdle, action("MarkIdle", outcome(Status::Running))};
+
+    Sequence act{&plan, &planned};
+    Selector root{&act, &idle};
+    EntityBrain brain{&root};
+
+    CachedSubtree cachedPlan{0, &plan};
+    Sequence cachedAct{&cachedPlan, &planned};
+    Selector cachedRoot{&cachedAct, &idle};
+    EntityBrain cachedBrain{&cachedRoot};
+};
+
+// Uncached vs cached ConditionTree on the same scripted workload: the wolf toggles every
+// 120 frames, the food moves every 300, and 1% of the agents flip IsHungry each frame.
+static int bench_cache(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 10'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const int reps = static_cast<int>(arg_or(args, "reps", 3));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+    ConditionTree tree;
+
+    auto setup = [&](World& world, EntityPool& pool){
+        Rng rng{5};
+        pool.spawn(count, rng);
+        world.rng = Rng{6};
+        world.add_obstacle({560.0f, 200.0f, 40.0f, 200.0f}); //blocks some of the food sightlines, not the route
+    };
+    auto script = [&](World& world, EntityPool& pool, Rng& rng){
+        world.update(dt);
+        if(world.frame % 120 == 0){ world.set_wolf_active(!world.wolf_active); }
+        if(world.frame % 300 == 0){ world.respawn_food(); }
+        for(std::size_t n = count / 100; n > 0; --n){
+            const auto i = static_cast<std::size_t>(rng.range(0, static_cast<int>(count) - 1));
+            pool.board().set<IsHungry>(i, !pool.board().get<IsHungry>(i), world.frame);
+        }
+    };
+    auto tick_all = [&](World& world, EntityPool& pool, const EntityBrain& brain, std::vector<Status>* out){
+        auto entities = pool.entities();
+        auto memory = pool.memory();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            Context ctx{entities[i], memory[i], world, pool.board(), pool.senses(), i};
+            const Status s = brain.tick(ctx, dt);
+            if(out){ (*out)[i] = s; }
+        }
+    };
+
+    //lockstep on one population: both brains must agree on every agent, every frame
+    {
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        setup(world, pool);
+        Rng rng{9};
+        std::vector<Status> plain(count), cached(count);
+        std::vector<Activity> plain_activity(count);
+        for(int f = 0; f < frames && failures == 0; ++f){
+            script(world, pool, rng);
+            tick_all(world, pool, tree.brain, &plain);
+            for(std::size_t i = 0; i < count; ++i){ plain_activity[i] = pool.entities()[i].activity; }
+            tick_all(world, pool, tree.cachedBrain, &cached);
+            for(std::size_t i = 0; i < count; ++i){
+                failures += (plain[i] == cached[i] && plain_activity[i] == pool.entities()[i].activity) ? 0 : 1;
+            }
+        }
+    }
+
+    auto time_brain = [&](const EntityBrain& brain){
+        return best_time_ns(reps, [&]{
+            World world;
+            EntityPool pool{Blackboard{DemoTree::Keys{}}};
+            setup(world, pool);
+            Rng rng{9};
+            for(int f = 0; f < frames; ++f){
+                script(world, pool, rng);
+                tick_all(world, pool, brain, nullptr);
+            }
+            keep(pool.entities()[0]);
+        });
+    };
+    const double plain_ns = time_brain(tree.brain);
+    tree.cachedPlan.stats = {};
+    const double cached_ns = time_brain(tree.cachedBrain);
+    const auto& s = tree.cachedPlan.stats;
+
+    const double visits = static_cast<double>(count) * frames;
+    std::printf("cache: %zu agents x %d frames, best of %d\n", count, frames, reps);
+    std::printf("  uncached tree          %8.2f ns/agent/frame (includes the scripted writes)\n", plain_ns / visits);
+    std::printf("  cached plan subtree    %8.2f ns/agent/frame  (%.1fx)\n", cached_ns / visits, plain_ns / cached_ns);
+    std::printf("  hit rate               %8.1f %%  (%llu hits, %llu misses, %llu uncached)\n", s.hit_rate() * 100.0,
+        static_cast<unsigned long long>(s.hits), static_cast<unsigned long long>(s.misses), static_cast<unsigned long long>(s.uncached));
+    DemoTree demo;
+    const CachedSubtree threat{0, &demo.threat};
+    std::printf("  DemoTree's ThreatNearby cacheable: %s (it reads the agent's position)\n", threat.cacheable ? "yes" : "no");
+    std::printf("  lockstep checks        %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
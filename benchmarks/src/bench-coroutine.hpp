@@ -0,0 +1,129 @@
+#pragma once
+#include "bench.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+
+// Resume cost of a pooled coroutine leaf vs a plain function-pointer leaf, and the
+// patrol branch of DemoTree vs CoroutineDemoTree on a whole population. Also checks
+// that frames are returned to the arena when the wolf preempts the patrol, and that a
+// preempted agent never resumes the action that took over its slot.
+static Status CountLeaf(Context& ctx, float) noexcept{
+    ++ctx.memory.bt_mem[7];
+    return Status::Running;
+}
+
+static Action CountAction(Tick& t){
+    for(;;){
+        ++t.context().memory.bt_mem[7];
+        co_await t.next_tick();
+    }
+}
+
+static int bench_coroutine(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 10'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 100));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    auto make_population = [&](EntityPool& pool){
+        Rng rng{11};
+        pool.spawn(count, rng);
+        for(auto& h : pool.board().column<Hunger>()){ h.value = 0.0f; } //keep everyone on patrol
+    };
+
+    //1. bare leaf call vs bare coroutine resume
+    World world;
+    world.wolf_active = false;
+    EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    make_population(pool);
+    CoroutineArena arena(count);
+    Leaf leaf{CountLeaf};
+    CoroutineLeaf co{0, CountAction, arena};
+    auto run_node = [&](const Node& node){
+        ++world.frame;
+        auto entities = pool.entities();
+        auto memory = pool.memory();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            Context ctx{entities[i], memory[i], world, pool.board(), pool.senses(), i};
+            std::ignore = node.tick(ctx, dt);
+        }
+    };
+    const double leaf_ns = best_time_ns(reps, [&]{ for(int f = 0; f < frames; ++f) run_node(leaf); });
+    const double co_ns = best_time_ns(reps, [&]{ for(int f = 0; f < frames; ++f) run_node(co); });
+    failures += (arena.in_use() == count) ? 0 : 1;
+
+    //2. whole trees, everyone patrolling
+    auto run_tree = [&](const EntityBrain& brain, CoroutineArena* a){
+        World w;
+        w.wolf_active = false;
+        EntityPool p{Blackboard{DemoTree::Keys{}}};
+        make_population(p);
+        return best_time_ns(reps, [&]{
+            for(int f = 0; f < frames; ++f){
+                simulate(w, brain, p, dt);
+                if(a) a->reap(w.frame);
+            }
+        });
+    };
+    DemoTree demo;
+    CoroutineDemoTree co_demo(count);
+    const double demo_ns = run_tree(demo.brain, nullptr);
+    const double co_demo_ns = run_tree(co_demo.brain, &co_demo.arena);
+    failures += (arena.failed_starts() == 0 && co_demo.arena.failed_starts() == 0) ? 0 : 1; //every action got a slot
+
+    //3. preemption: with the wolf parked on top of the agents, flee wins and patrol frames are reaped
+    {
+        World w;
+        EntityPool p{Blackboard{DemoTree::Keys{}}};
+        make_population(p);
+        CoroutineDemoTree tree(count);
+        w.wolf_active = false;
+        simulate(w, tree.brain, p, dt);
+        tree.arena.reap(w.frame);
+        const auto patrolling = tree.arena.in_use();
+        w.set_wolf_active(true);
+        for(auto& e : p.entities()){ e.position = w.wolf_pos + Vector2{1.0f, 0.0f}; }
+        simulate(w, tree.brain, p, dt);
+        tree.arena.reap(w.frame);
+        failures += (patrolling == count && tree.arena.in_use() == 0 && tree.arena.failed_starts() == 0) ? 0 : 1;
+        std::printf("  preemption: %zu frames in use while patrolling, %zu after the wolf arrived\n", patrolling, tree.arena.in_use());
+    }
+
+    //4. a preempted agent's stale code: its slot is reaped and handed to another agent, and the
+    //   preempted agent must start an action of its own instead of resuming the other's
+    {
+        World w;
+        w.wolf_active = false;
+        EntityPool p{Blackboard{DemoTree::Keys{}}};
+        Rng rng{5};
+        p.spawn(2, rng);
+        CoroutineArena small(2);
+        CoroutineLeaf co_count{0, CountAction, small};
+        auto tick_row = [&](std::size_t i){
+            Context ctx{p.entities()[i], p.memory()[i], w, p.board(), p.senses(), i};
+            std::ignore = co_count.tick(ctx, dt);
+        };
+        w.frame = 1;
+        tick_row(0);
+        small.reap(w.frame);
+        w.frame = 2; //row 0 is preempted
+        small.reap(w.frame);
+        w.frame = 3;
+        tick_row(1); //takes the slot row 0 had
+        tick_row(0);
+        small.reap(w.frame);
+        const bool own = (small.in_use() == 2 && p.memory()[0].bt_mem[0] != p.memory()[1].bt_mem[0]);
+        failures += own ? 0 : 1;
+        std::printf("  stale code: %s\n", own ? "the preempted agent started its own action" : "RESUMED ANOTHER AGENT'S ACTION");
+    }
+
+    const double visits = static_cast<double>(count) * frames;
+    std::printf("coroutine: %zu agents x %d frames, best of %d, %zu-byte frame slots\n", count, frames, reps, arena.frame_bytes());
+    std::printf("  function-pointer leaf   %8.2f ns/tick\n", leaf_ns / visits);
+    std::printf("  coroutine leaf resume   %8.2f ns/tick\n", co_ns / visits);
+    std::printf("  DemoTree (patrol)       %8.2f ns/agent/frame\n", demo_ns / visits);
+    std::printf("  CoroutineDemoTree       %8.2f ns/agent/frame\n", co_demo_ns / visits);
+    std::printf("  checks                  %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
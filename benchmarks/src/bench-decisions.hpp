@@ -0,0 +1,90 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "decision-table.hpp"
+
+// DemoTree's root decision by tree traversal vs by DecisionTable: guard bitmasks for the whole
+// population, then one table lookup and the chosen branch's actions per agent. The two runs go
+// in lockstep and must stay identical. "tick" is everything between perception and integration;
+// for the table that includes evaluating the guards, which is also shown on its own.
+static int bench_decisions(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    };
+    auto make = [&]{
+        Run r;
+        r.world.rng = Rng{9};
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        return r;
+    };
+    DemoTree tree;
+    DecisionTable table{tree.root, demo_batch_conditions};
+    Run plain = make();
+    Run compiled = make();
+
+    // simulate() with the tick timed on its own, like bench-buckets
+    auto integrate = [&](Run& r, bool flocking){
+        auto entities = r.pool.entities();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            if(flocking){ flock(r.pool.neighbors(), entities[i], i); }
+            entities[i].update(dt);
+        }
+        apply_commands(r.world, r.pool, {&r.world.commands, 1});
+    };
+    double plain_ns = 0.0, table_ns = 0.0, evaluate_ns = 0.0;
+    for(int f = 0; f < frames; ++f){
+        bool flocking = prepare_step(plain.world, plain.pool, dt);
+        plain_ns += time_ns([&]{
+            auto entities = plain.pool.entities();
+            auto memory = plain.pool.memory();
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], plain.world, plain.pool.board(), plain.pool.senses(), i, &plain.world.commands};
+                std::ignore = tree.brain.tick(ctx, dt);
+            }
+        });
+        integrate(plain, flocking);
+
+        flocking = prepare_step(compiled.world, compiled.pool, dt);
+        const double eval = time_ns([&]{ table.evaluate(compiled.world, compiled.pool); });
+        evaluate_ns += eval;
+        table_ns += eval + time_ns([&]{
+            auto entities = compiled.pool.entities();
+            auto memory = compiled.pool.memory();
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], compiled.world, compiled.pool.board(), compiled.pool.senses(), i, &compiled.world.commands};
+                std::ignore = table.tick(ctx, dt);
+            }
+        });
+        integrate(compiled, flocking);
+
+        const auto a = plain.pool.entities(), b = compiled.pool.entities();
+        for(std::size_t i = 0; i < count; ++i){
+            failures += (a[i].activity == b[i].activity && a[i].position.x == b[i].position.x && a[i].position.y == b[i].position.y) ? 0 : 1;
+        }
+        if(failures > 0){
+            std::printf("  runs diverge at frame %d\n", f);
+            break;
+        }
+    }
+
+    const auto counts = table.branch_counts();
+    const double agent_frames = static_cast<double>(count) * frames;
+    std::printf("decisions: %zu agents x %d frames, DemoTree\n", count, frames);
+    std::printf("  table: %zu guards (%zu batched), %zu branches, %zu bytes; last frame's branches:",
+        table.guard_count(), table.batched_guards(), counts.size() - 1, table.table_bytes());
+    for(const auto c : counts){ std::printf(" %u", c); }
+    std::printf("\n");
+    std::printf("  %-22s %8.2f ns/agent tick\n", "tree traversal", plain_ns / agent_frames);
+    std::printf("  %-22s %8.2f ns/agent tick  (guard bitmasks %.2f)\n", "DecisionTable", table_ns / agent_frames, evaluate_ns / agent_frames);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (the table changed a decision)");
+    return failures;
+}
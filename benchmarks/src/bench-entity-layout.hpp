@@ -0,0 +1,99 @@
+#pragma once
+#include "bench.hpp"
+#include "steering.hpp"
+#include "world.hpp"
+#include "game-ai.hpp"
+
+// The Entity layout before the hot/cold split: hot and cold fields interleaved,
+// plus a 16-byte string_view written by every action leaf.
+struct LegacyEntity final{
+    int waypoint_index = 0;
+    std::array<int, 8> bt_mem{};
+    float hunger = 0.0f;
+    bool isHungry = false;
+    std::string_view debug_state = "None";
+    Vector2 position = ZERO;
+    Vector2 acceleration = ZERO;
+    Vector2 velocity = ZERO;
+};
+
+// One DemoTree-shaped decision (flee / seek food / patrol) plus integration, written once
+// for both layouts. `hot(i)` returns the fields every agent touches, `hunger(i)` the hunger value
+// (integrated every frame, as before linear-stat.hpp), `hungry(i)` the hunger flag, `waypoint(i)`
+// the patrol state that only patrolling agents read, `mark(i, a)` records the debug state.
+template <typename Hot, typename HungerValue, typename Hungry, typename Waypoint, typename Mark>
+static void layout_frame(std::size_t count, const World& world, float dt, Hot hot, HungerValue hunger, Hungry hungry, Waypoint waypoint, Mark mark) noexcept{
+    for(std::size_t i = 0; i < count; ++i){
+        auto& e = hot(i);
+        float& fed = hunger(i);
+        Vector2 target = world.food_pos;
+        float speed = Entity::max_speed * 0.7f;
+        if(Vector2Distance(e.position, world.wolf_pos) < 180.0f){
+            target = e.position + (e.position - world.wolf_pos);
+            speed = Entity::max_speed;
+            mark(i, Activity::Flee);
+        } else if(bool& h = hungry(i); h || fed > 0.95f){
+            h = fed > 0.05f;
+            mark(i, Activity::SeekFood);
+        } else{
+            target = world.waypoints[waypoint(i)];
+            speed = Entity::max_speed * 0.65f;
+            mark(i, Activity::Patrol);
+        }
+        e.acceleration = (Vector2Normalize(target - e.position) * speed - e.velocity) + e.velocity * -Entity::drag;
+        fed = std::clamp(fed + Hunger::per_second * dt, 0.0f, 1.0f);
+        e.velocity = Vector2ClampValue(e.velocity + e.acceleration * dt, Entity::min_speed, Entity::max_speed);
+        e.position = wrap(e.position + e.velocity * dt);
+        e.acceleration = ZERO;
+    }
+}
+
+static int bench_entity_layout(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 1'000'000));
+    const int reps = static_cast<int>(arg_or(args, "reps", 10));
+    const float dt = 1.0f / 60.0f;
+    World world;
+    const auto px = random_floats(count, 0.0f, STAGE_SIZE.x, 7);
+    const auto py = random_floats(count, 0.0f, STAGE_SIZE.y, 8);
+    const auto hunger = random_floats(count, 0.0f, 1.0f, 9);
+
+    std::vector<LegacyEntity> legacy(count);
+    std::vector<Entity> hot(count);
+    std::vector<float> hot_hunger(count);
+    Blackboard board{DemoTree::Keys{}};
+    board.append(count, nullptr);
+    auto hungry = board.column<IsHungry>();
+    auto waypoints = board.column<WaypointIndex>();
+    for(std::size_t i = 0; i < count; ++i){
+        legacy[i].position = hot[i].position = {px[i], py[i]};
+        legacy[i].velocity = hot[i].velocity = {Entity::min_speed, 0.0f};
+        legacy[i].hunger = hot_hunger[i] = hunger[i];
+        legacy[i].waypoint_index = waypoints[i] = static_cast<int>(i % 4);
+    }
+
+    const double legacy_ns = best_time_ns(reps, [&]{
+        layout_frame(count, world, dt,
+            [&](std::size_t i) -> LegacyEntity&{ return legacy[i]; },
+            [&](std::size_t i) -> float&{ return legacy[i].hunger; },
+            [&](std::size_t i) -> bool&{ return legacy[i].isHungry; },
+            [&](std::size_t i){ return legacy[i].waypoint_index; },
+            [&](std::size_t i, Activity a){ legacy[i].debug_state = to_string(a); });
+    });
+    const double split_ns = best_time_ns(reps, [&]{
+        layout_frame(count, world, dt,
+            [&](std::size_t i) -> Entity&{ return hot[i]; },
+            [&](std::size_t i) -> float&{ return hot_hunger[i]; },
+            [&](std::size_t i) -> bool&{ return hungry[i]; },
+            [&](std::size_t i){ return waypoints[i]; },
+            [&](std::size_t i, Activity a){ hot[i].activity = a; });
+    });
+    keep(legacy[count / 2]);
+    keep(hot[count / 2]);
+
+    std::printf("entity-layout: %zu agents, best of %d\n", count, reps);
+    std::printf("%-10s %8s %8s %12s %10s\n", "layout", "hot B", "cold B", "frame ms", "ns/agent");
+    std::printf("%-10s %8zu %8d %12.3f %10.2f\n", "legacy", sizeof(LegacyEntity), 0, legacy_ns * 1e-6, legacy_ns / static_cast<double>(count));
+    std::printf("%-10s %8zu %8zu %12.3f %10.2f\n", "hot/cold", sizeof(Entity), board.bytes_per_row() + sizeof(float), split_ns * 1e-6, split_ns / static_cast<double>(count));
+    std::printf("speedup %.2fx\n", legacy_ns / split_ns);
+    return 0;
+}
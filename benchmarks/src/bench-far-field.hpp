@@ -0,0 +1,121 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "far-field.hpp"
+
+// Everyone in full vs FarField, with the viewer circling the stage so agents keep being promoted
+// and demoted. The runs make different decisions far away, so they are compared by outcome
+// (activity mix, food eaten) rather than in lockstep. The far-field run checks that no agent
+// moves further in a frame than max_speed allows (no popping). From the measured cost of a full
+// agent, a distant one and the passes everyone goes through, it works out how many agents the
+// 60 Hz budget affords in full at this population.
+static int bench_far_field(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const float view = static_cast<float>(arg_or(args, "view", 240));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{FarField::Keys{}}};
+    };
+    auto make = [&]{
+        Run r;
+        r.world.rng = Rng{9};
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        return r;
+    };
+    DemoTree tree;
+    FarField far;
+    far.view_radius = view;
+    Run full = make();
+    Run mixed = make();
+
+    double full_ns = 0.0, shared_ns = 0.0, sense_ns = 0.0, tick_ns = 0.0, coarse_ns = 0.0;
+    double full_rows = 0.0, promoted = 0.0, demoted = 0.0;
+    float reference_dv = 0.0f, full_dv = 0.0f, distant_dv = 0.0f; //largest |dv/dt|, px/s^2
+    std::array<std::size_t, 4> full_activity{}, mixed_activity{};
+    std::vector<Entity> before;
+    std::vector<std::uint8_t> was_distant;
+    for(int f = 0; f < frames; ++f){
+        const auto reference = full.pool.entities();
+        before.assign(reference.begin(), reference.end());
+        full_ns += time_ns([&]{ simulate(full.world, tree.brain, full.pool, dt); });
+        if((full.world.frame - 1) % full.world.resort_period != 0){ //not re-sorted: rows are as before
+            for(std::size_t i = 0; i < count; ++i){ reference_dv = std::max(reference_dv, Vector2Distance(reference[i].velocity, before[i].velocity) / dt); }
+        }
+
+        const float angle = 0.5f * mixed.world.time;
+        far.viewer = STAGE_SIZE * 0.5f + Vector2{std::cos(angle) * 360.0f, std::sin(angle) * 200.0f};
+        bool flocking = false;
+        shared_ns += time_ns([&]{
+            advance(mixed.world, mixed.pool, dt);
+            far.classify(mixed.world, mixed.pool);
+        });
+        sense_ns += time_ns([&]{ flocking = far.sense(mixed.world, mixed.pool); });
+        const auto entities = mixed.pool.entities();
+        before.assign(entities.begin(), entities.end());
+        const auto distant = mixed.pool.board().column<Distant>();
+        was_distant.assign(distant.begin(), distant.end());
+        tick_ns += time_ns([&]{
+            auto memory = mixed.pool.memory();
+            for(const std::size_t i : far.full_rows()){
+                Context ctx{entities[i], memory[i], mixed.world, mixed.pool.board(), mixed.pool.senses(), i, &mixed.world.commands};
+                std::ignore = tree.brain.tick(ctx, dt);
+                if(flocking){ flock(mixed.pool.neighbors(), entities[i], i); }
+                entities[i].update(dt);
+            }
+        });
+        coarse_ns += time_ns([&]{ far.step(mixed.world, mixed.pool, dt); });
+        apply_commands(mixed.world, mixed.pool, {&mixed.world.commands, 1});
+        full_rows += static_cast<double>(far.full_rows().size());
+        promoted += static_cast<double>(far.promoted());
+        demoted += static_cast<double>(far.demoted());
+
+        for(std::size_t i = 0; i < count; ++i){
+            const Vector2 p = before[i].position;
+            const bool edge = std::min({p.x, p.y, STAGE_WIDTH - p.x, STAGE_HEIGHT - p.y}) < 2.0f * ENTITY_SIZE;
+            if(edge) continue; //wrap() moves agents around the stage, full and distant alike
+            const float moved = Vector2Distance(entities[i].position, p);
+            failures += (moved <= Entity::max_speed * dt * 1.001f) ? 0 : 1;
+            float& dv = was_distant[i] ? distant_dv : full_dv;
+            dv = std::max(dv, Vector2Distance(entities[i].velocity, before[i].velocity) / dt);
+        }
+        if(failures > 0){
+            std::printf("  an agent jumped at frame %d\n", f);
+            break;
+        }
+        for(const auto& e : full.pool.entities()){ ++full_activity[static_cast<std::size_t>(e.activity)]; }
+        for(const auto& e : entities){ ++mixed_activity[static_cast<std::size_t>(e.activity)]; }
+    }
+
+    const double agent_frames = static_cast<double>(count) * frames;
+    const double distant_rows = agent_frames - full_rows;
+    const double a = (tick_ns + sense_ns) / std::max(full_rows, 1.0); //per full agent, sensing and flocking included
+    const double b = coarse_ns / std::max(distant_rows, 1.0);  //per distant agent
+    const double c = shared_ns / agent_frames;                 //per agent, everyone
+    const double budget = 1e9 / 60.0;
+    const double affordable = std::clamp((budget - count * (b + c)) / (a - b), 0.0, static_cast<double>(count));
+    auto mix = [&](const std::array<std::size_t, 4>& m){
+        std::printf("  flee %5.1f %%  patrol %5.1f %%  seek food %5.1f %%", 100.0 * m[1] / agent_frames, 100.0 * m[2] / agent_frames, 100.0 * m[3] / agent_frames);
+    };
+    std::printf("far field: %zu agents x %d frames, DemoTree, view radius %.0f\n", count, frames, view);
+    std::printf("  in full %5.1f %% of agents on average; per frame %.1f promoted, %.1f demoted\n", 100.0 * full_rows / agent_frames, promoted / frames, demoted / frames);
+    std::printf("  %-22s %8.2f ns/agent frame\n", "everyone in full", full_ns / agent_frames);
+    std::printf("  %-22s %8.2f ns/agent frame  (shared %.2f, per full agent %.2f, per distant agent %.2f)\n", "far field",
+        (shared_ns + sense_ns + tick_ns + coarse_ns) / agent_frames, c, a, b);
+    std::printf("  in full within 16.7 ms at %zu agents: %.0f\n", count, affordable);
+    std::printf("  largest |dv/dt|: everyone in full %.0f px/s^2; far field: full agents %.0f, distant agents %.0f\n", reference_dv, full_dv, distant_dv);
+    std::printf("  everyone in full:");
+    mix(full_activity);
+    std::printf("  food eaten %u\n", full.world.food_serial);
+    std::printf("  far field:       ");
+    mix(mixed_activity);
+    std::printf("  food eaten %u\n", mixed.world.food_serial);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (an agent moved faster than max_speed)");
+    return failures;
+}
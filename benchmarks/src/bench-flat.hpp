@@ -0,0 +1,74 @@
+#pragma once
+#include "bench.hpp"
+#include "bench-nodes.hpp"
+#include "flat-tree.hpp"
+#include "game-ai.hpp"
+#include "tree-optimizer.hpp"
+
+// Node-per-object trees vs the same trees copied into a FlatTree: memory, build/destroy
+// cost and tick speed over growing tree sizes, random shapes, and DemoTree in simulate().
+static int bench_flat(Args args){
+    using namespace nodes_bench;
+    const int reps = static_cast<int>(arg_or(args, "reps", 3));
+    const auto max_nodes = static_cast<std::size_t>(arg_or(args, "max-nodes", 6'000'000));
+    int failures = 0;
+    leaf_cost = 0;
+    Harness h;
+
+    std::printf("flat: best of %d\n", reps);
+    std::printf("%-22s %10s %12s %12s %10s %10s %8s\n", "tree", "nodes", "objects B", "flat B", "obj ns/v", "flat ns/v", "speedup");
+    auto compare = [&](const char* label, const Shape& shape, std::size_t visits_per_tick){
+        const Synthetic objects = build(shape, false);
+        const FlatTree flat{*objects.root};
+        const int ticks = static_cast<int>(std::max<std::size_t>(1, 2'000'000 / visits_per_tick));
+        const double obj_ns = best_time_ns(reps, [&]{ h.run(*objects.root, ticks); }) / (static_cast<double>(visits_per_tick) * ticks);
+        const double flat_ns = best_time_ns(reps, [&]{ h.run(flat, ticks); }) / (static_cast<double>(visits_per_tick) * ticks);
+        std::printf("%-22s %10zu %12zu %12zu %10.2f %10.2f %7.2fx\n", label, flat.node_count(), objects.bytes, flat.bytes(), obj_ns, flat_ns, obj_ns / flat_ns);
+    };
+    for(int d = 2;; d += 2){
+        std::size_t nodes = 0;
+        for(std::size_t level = 0, w = 1; level <= static_cast<std::size_t>(d); ++level, w *= 4){ nodes += w; }
+        if(nodes > max_nodes) break;
+        char label[32];
+        std::snprintf(label, sizeof(label), "all visited, depth %d", d);
+        compare(label, Shape{d, 4, false, true, 1}, nodes);
+    }
+    for(const bool random : {false, true}){
+        const Shape shape{8, 4, random, false, 1};
+        const Synthetic counted = build(shape, true);
+        visits = 0;
+        h.run(*counted.root, 1'000);
+        compare(random ? "random, coin leaves" : "random, fixed leaves", shape, std::max<std::uint64_t>(visits / 1'000, 1));
+    }
+
+    //load + destroy: one allocation vs one per node and per child vector
+    {
+        const Shape shape{8, 4, false, true, 1};
+        const Synthetic source = build(shape, false);
+        const double n = static_cast<double>(FlatTree{*source.root}.node_count());
+        const double objects_ns = best_time_ns(reps, [&]{ const Synthetic t = build(shape, false); keep(t.root); });
+        const double flat_ns = best_time_ns(reps, [&]{ const FlatTree t{*source.root}; keep(t.records()[0]); });
+        std::printf("build + destroy, %.0f nodes: objects %.2f ns/node, flat %.2f ns/node (copied from the objects)\n", n, objects_ns / n, flat_ns / n);
+    }
+
+    //DemoTree: identical behavior, tick cost inside the full simulation step
+    {
+        DemoTree demo;
+        const FlatTree flat{demo.root};
+        const EntityBrain flat_brain{const_cast<FlatTree*>(&flat)};
+        Workload workload{Blackboard{DemoTree::Keys{}}};
+        const int diverged = verify_trace(demo.brain, flat_brain, workload);
+        failures += (diverged < 0) ? 0 : 1;
+        auto time_brain = [&](const EntityBrain& brain){
+            return best_time_ns(reps, [&]{
+                Replay replay(workload);
+                for(int f = 0; f < workload.frames; ++f){ replay.step(brain); }
+                keep(replay.population.entities()[0]);
+            }) / (static_cast<double>(workload.agents) * workload.frames);
+        };
+        std::printf("DemoTree (%zu nodes, %zu B flat): simulate %.2f -> %.2f ns/agent/frame, trace %s\n",
+            flat.node_count(), flat.bytes(), time_brain(demo.brain), time_brain(flat_brain), diverged < 0 ? "identical" : "DIVERGED");
+    }
+    std::printf("checks %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
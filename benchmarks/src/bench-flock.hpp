@@ -0,0 +1,125 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "flocking.hpp"
+
+// Flocking over the cell-sorted neighbor grid: grid build and neighbor kernel cost, the whole
+// DemoTree frame with and without it against the 60 Hz budget, how much it keeps agents apart,
+// and a check of the grid's forces against an all-pairs search, with a few agents stacked on
+// one spot.
+static int bench_flock(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 300));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    //1. the grid's forces vs all pairs, without the candidate cap
+    {
+        const std::size_t n = 2000;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        Rng rng{5};
+        pool.spawn(n, rng);
+        const auto entities = pool.entities();
+        constexpr std::size_t stacked = 8; //agents on exactly the same spot, as when spawned on one point
+        for(std::size_t i = 1; i < stacked; ++i){ entities[i].position = entities[0].position; }
+        Tuning all;
+        all.separation_weight = all.alignment_weight = all.cohesion_weight = 1.0f;
+        NeighborGrid grid;
+        grid.build(entities);
+        flock_rows(grid, all, 0, NeighborGrid::rows, n);
+        constexpr float r2 = NeighborGrid::radius * NeighborGrid::radius;
+        std::vector<std::uint32_t> entry(n); //each row's grid entry, which orders agents on the same spot
+        for(std::uint32_t e = 0; e < n; ++e){ entry[grid.row[e]] = e; }
+        for(std::size_t i = 0; i < n; ++i){
+            const Vector2 p = entities[i].position;
+            NeighborSums want;
+            for(std::size_t j = 0; j < n; ++j){
+                const Vector2 d = entities[j].position - p;
+                const float d2 = Vector2LengthSqr(d);
+                if(j == i || d2 >= r2) continue;
+                const Vector2 apart = (d2 > 0.0f) ? d : Vector2{entry[j] > entry[i] ? 1.0f : -1.0f, 0.0f};
+                want.count += 1.0f;
+                want.offset += d;
+                want.velocity += entities[j].velocity;
+                want.away -= apart * (1.0f / std::max(d2, 1.0f));
+            }
+            const Vector2 expected = steer_flock(entities[i], want, all);
+            const Vector2 got = {grid.force_x[i], grid.force_y[i]};
+            failures += (Vector2Length(got - expected) <= 1e-3f * (Vector2Length(expected) + Entity::max_speed)) ? 0 : 1;
+        }
+        Tuning apart; //separation alone must still push the stacked agents apart
+        apart.alignment_weight = apart.cohesion_weight = 0.0f;
+        flock_rows(grid, apart, 0, NeighborGrid::rows, n);
+        for(std::size_t i = 0; i < stacked; ++i){
+            failures += (Vector2LengthSqr({grid.force_x[i], grid.force_y[i]}) > 0.0f) ? 0 : 1;
+        }
+    }
+
+    //2. cost at `count` agents
+    World world;
+    EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    Rng rng{3};
+    pool.spawn(count, rng);
+    DemoTree tree;
+    auto& grid = pool.neighbors();
+    const double build_ns = best_time_ns(reps, [&]{ grid.build(pool.entities()); });
+    const double flock_ns = best_time_ns(reps, [&]{ flock_rows(grid, world.tuning, 0, NeighborGrid::rows); });
+    std::size_t candidates = 0, capped = 0; //per agent, the cell's candidates looked at
+    for(int c = 0; c < NeighborGrid::cell_count; ++c){
+        std::array<CandidateSpan, 3> spans{};
+        const std::size_t used = candidates_of(grid, c % NeighborGrid::cols, c / NeighborGrid::cols, grid.size(), spans);
+        std::size_t all = 0;
+        for(std::size_t k = 0; k < used; ++k){ all += spans[k].second - spans[k].first; }
+        const std::size_t agents = grid.start[c + 1] - grid.start[c];
+        candidates += agents * std::min(all, NeighborGrid::max_candidates);
+        capped += (all > NeighborGrid::max_candidates) ? agents : 0;
+    }
+
+    //3. the whole frame, and how crowded it gets, with and without flocking
+    auto run = [&](const Tuning& tuning, double& frame_ns){
+        World w;
+        w.tuning = tuning;
+        EntityPool p{Blackboard{DemoTree::Keys{}}};
+        Rng r{3};
+        p.spawn(count, r);
+        for(int f = 0; f < frames; ++f){ simulate(w, tree.brain, p, dt); }
+        frame_ns = best_time_ns(reps, [&]{ simulate(w, tree.brain, p, dt); });
+        NeighborGrid g; //agents with another agent closer than their own size
+        g.build(p.entities());
+        std::size_t overlapping = 0;
+        for(std::size_t i = 0; i < p.size(); ++i){
+            const Vector2 pos = p.entities()[i].position;
+            const int c = NeighborGrid::cell_of(pos);
+            const int cx = c % NeighborGrid::cols, cy = c / NeighborGrid::cols;
+            bool close = false;
+            for(int y = std::max(cy - 1, 0); y <= std::min(cy + 1, NeighborGrid::rows - 1) && !close; ++y){
+                const auto begin = g.start[y * NeighborGrid::cols + std::max(cx - 1, 0)];
+                const auto end = g.start[y * NeighborGrid::cols + std::min(cx + 1, NeighborGrid::cols - 1) + 1];
+                for(auto j = begin; j < end && !close; ++j){
+                    const float d2 = Vector2LengthSqr(Vector2{g.pos_x[j], g.pos_y[j]} - pos);
+                    close = d2 > 0.0f && d2 < ENTITY_SIZE * ENTITY_SIZE;
+                }
+            }
+            overlapping += close ? 1 : 0;
+        }
+        return 100.0 * static_cast<double>(overlapping) / static_cast<double>(p.size());
+    };
+    Tuning off;
+    off.separation_weight = off.alignment_weight = off.cohesion_weight = 0.0f;
+    double off_ns = 0.0, on_ns = 0.0;
+    const double off_crowded = run(off, off_ns);
+    const double on_crowded = run(Tuning{}, on_ns);
+
+    const double n = static_cast<double>(count);
+    std::printf("flock: %zu agents, radius %.0f, max %zu candidates, %s, best of %d\n", count, NeighborGrid::radius, NeighborGrid::max_candidates, simd::backend, reps);
+    std::printf("  %-28s %8.2f ns/agent\n", "grid build", build_ns / n);
+    std::printf("  %-28s %8.2f ns/agent  %.1f candidates/agent, %.1f%% of agents capped\n", "flock_rows", flock_ns / n, candidates / n, 100.0 * capped / n);
+    std::printf("  %-28s %8.3f ms/frame  crowded %5.1f%%\n", "simulate, no flocking", off_ns * 1e-6, off_crowded);
+    std::printf("  %-28s %8.3f ms/frame  crowded %5.1f%%  (60 Hz budget: 16.667 ms)\n", "simulate, separation", on_ns * 1e-6, on_crowded);
+    std::printf("  crowded = agents with another agent within ENTITY_SIZE, after %d frames\n", frames);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (grid forces differ from all pairs)");
+    return failures;
+}
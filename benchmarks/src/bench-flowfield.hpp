@@ -0,0 +1,51 @@
+#pragma once
+#include "bench.hpp"
+#include "world.hpp"
+
+// Cost of building flow fields (full grid, the wolf's danger radius, the obstacle-free
+// shortcut) and of sampling them per agent, compared with a plain straight-line normalize.
+static int bench_flowfield(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int reps = static_cast<int>(arg_or(args, "reps", 20));
+    World world;
+    const auto px = random_floats(count, 0.0f, STAGE_SIZE.x, 5);
+    const auto py = random_floats(count, 0.0f, STAGE_SIZE.y, 6);
+
+    auto build = [&](FlowField& field, Vector2 goal){
+        field.set_goal(world.grid, goal);
+        while(field.update(world.grid, FlowGrid::cell_count)){}
+    };
+    auto rebuild_ns = [&](FlowField& field){
+        bool flip = false;
+        return best_time_ns(reps, [&]{ //alternate between two goal cells so every call is a real rebuild
+            flip = !flip;
+            build(field, flip ? Vector2{100.0f, 100.0f} : Vector2{1100.0f, 600.0f});
+        });
+    };
+
+    std::printf("flowfield: %dx%d grid, %zu agents\n", FlowGrid::cols, FlowGrid::rows, count);
+    FlowField open_field;
+    std::printf("  set_goal, no obstacles     %10.0f ns\n", rebuild_ns(open_field));
+
+    world.add_obstacle({300.0f, 100.0f, 40.0f, 400.0f});
+    world.add_obstacle({700.0f, 250.0f, 40.0f, 470.0f});
+    world.add_obstacle({900.0f, 80.0f, 250.0f, 40.0f});
+    FlowField full;
+    FlowField danger{World::danger_radius};
+    std::printf("  rebuild, full grid         %10.0f ns  (%d obstacle cells)\n", rebuild_ns(full), world.grid.obstacle_count);
+    std::printf("  rebuild, danger radius     %10.0f ns\n", rebuild_ns(danger));
+
+    build(full, STAGE_SIZE * 0.5f);
+    float sink = 0.0f;
+    const double straight = best_time_ns(reps, [&]{
+        for(std::size_t i = 0; i < count; ++i){ sink += Vector2Normalize(STAGE_SIZE * 0.5f - Vector2{px[i], py[i]}).x; }
+    });
+    const double sampled = best_time_ns(reps, [&]{
+        for(std::size_t i = 0; i < count; ++i){ sink += full.direction({px[i], py[i]}).x; }
+    });
+    keep(sink);
+    const double n = static_cast<double>(count);
+    std::printf("  straight-line direction    %10.2f ns/agent\n", straight / n);
+    std::printf("  flow field direction       %10.2f ns/agent\n", sampled / n);
+    return 0;
+}
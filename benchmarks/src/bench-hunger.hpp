@@ -0,0 +1,81 @@
+#pragma once
+#include "bench.hpp"
+#include "linear-stat.hpp"
+#include "simulation.hpp"
+
+// Hunger integrated and threshold-tested every frame (the old Entity::update + CheckHunger)
+// vs hunger as a LinearStat whose threshold crossings are scheduled on a TimerQueue.
+// Both run the same rule: cross hunger_on, eat, start over from 0. They must count the
+// same meals, give or take float rounding of the crossing frame.
+static int bench_hunger(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 3600));
+    const int reps = static_cast<int>(arg_or(args, "reps", 3));
+    const float dt = 1.0f / 60.0f;
+    const float on = Tuning{}.hunger_on;
+    const auto start = random_floats(count, 0.0f, 1.0f, 5);
+    int failures = 0;
+
+    std::size_t eager_meals = 0;
+    const double eager_ns = best_time_ns(reps, [&]{
+        std::vector<float> hunger(start);
+        std::size_t meals = 0;
+        for(int f = 0; f < frames; ++f){
+            for(auto& h : hunger){
+                h = std::clamp(h + Hunger::per_second * dt, 0.0f, 1.0f);
+                if(h >= on){
+                    h = 0.0f;
+                    ++meals;
+                }
+            }
+        }
+        eager_meals = meals;
+        keep(hunger[count / 2]);
+    });
+
+    std::size_t event_meals = 0;
+    std::size_t peak_timers = 0;
+    const double event_ns = best_time_ns(reps, [&]{
+        std::vector<LinearStat> hunger(count);
+        TimerQueue<std::uint32_t> timers;
+        for(std::size_t i = 0; i < count; ++i){
+            hunger[i] = {start[i], Hunger::per_second, 0.0f};
+            timers.schedule(hunger[i].when(on), static_cast<std::uint32_t>(i));
+        }
+        peak_timers = timers.size();
+        std::size_t meals = 0;
+        float now = 0.0f;
+        for(int f = 0; f < frames; ++f){
+            now += dt;
+            timers.pop_due(now, [&](std::uint32_t i){
+                hunger[i].set(0.0f, now);
+                timers.schedule(hunger[i].when(on), i);
+                ++meals;
+            });
+        }
+        event_meals = meals;
+        keep(hunger[count / 2]);
+    });
+
+    //the same comparison inside the whole frame: DemoTree in simulate()
+    World world;
+    EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    Rng rng{3};
+    pool.spawn(count, rng);
+    DemoTree tree;
+    for(int f = 0; f < 60; ++f){ simulate(world, tree.brain, pool, dt); }
+    const double sim_ns = best_time_ns(reps, [&]{ simulate(world, tree.brain, pool, dt); });
+    const std::size_t pending = pool.timers().size();
+
+    const double agent_frames = static_cast<double>(count) * frames;
+    const double diff = std::abs(static_cast<double>(eager_meals) - static_cast<double>(event_meals));
+    failures += (diff <= 0.001 * static_cast<double>(eager_meals) + 1.0) ? 0 : 1;
+    std::printf("hunger: %zu agents x %d frames, best of %d\n", count, frames, reps);
+    std::printf("  %-26s %8.3f ns/agent/frame  %zu meals\n", "integrate + test, eager", eager_ns / agent_frames, eager_meals);
+    std::printf("  %-26s %8.3f ns/agent/frame  %zu meals, %zu timers, %.1f due/frame\n", "LinearStat + TimerQueue", event_ns / agent_frames,
+        event_meals, peak_timers, static_cast<double>(event_meals) / frames);
+    std::printf("  speedup %.1fx\n", eager_ns / event_ns);
+    std::printf("  %-26s %8.2f ns/agent/frame  %zu pending hunger timers\n", "simulate(DemoTree)", sim_ns / static_cast<double>(count), pending);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (meal counts differ)");
+    return failures;
+}
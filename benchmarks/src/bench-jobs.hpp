@@ -0,0 +1,66 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "frame-graph.hpp"
+#include "bench-pipeline.hpp" //same_agents
+
+// simulate() vs SimulationGraph on 1..N threads, plus the last frame's critical path and
+// per-thread timeline. Checks that every thread count ends on bit-identical agents.
+static int bench_jobs(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 50'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 120));
+    const auto chunk = static_cast<std::size_t>(arg_or(args, "chunk", SimulationGraph::default_chunk_rows));
+    const auto max_threads = static_cast<std::size_t>(arg_or(args, "threads", std::max(1u, std::thread::hardware_concurrency())));
+    const int reps = static_cast<int>(arg_or(args, "reps", 3));
+    const float dt = 1.0f / 60.0f;
+    DemoTree tree;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        explicit Run(std::size_t count){
+            Rng rng{21};
+            pool.spawn(count, rng);
+            world.rng = Rng{22};
+            world.add_obstacle({600.0f, 200.0f, 40.0f, 300.0f});
+        }
+    };
+    auto same = [](const Run& a, const Run& b){
+        return same_agents(a.pool.entities(), b.pool.entities()) && a.world.food_serial == b.world.food_serial && a.world.rng.state == b.world.rng.state;
+    };
+
+    Run reference{count};
+    for(int f = 0; f < frames; ++f){ simulate(reference.world, tree.brain, reference.pool, dt); }
+    const double serial_ns = best_time_ns(reps, [&]{
+        Run r{count};
+        for(int f = 0; f < frames; ++f){ simulate(r.world, tree.brain, r.pool, dt); }
+    }) / frames;
+
+    std::printf("jobs: %zu agents x %d frames, %zu-agent chunks, best of %d, food eaten %u times\n",
+        count, frames, chunk, reps, reference.world.food_serial);
+    std::printf("  %-22s %10.1f us/frame\n", "simulate()", serial_ns / 1000.0);
+    for(std::size_t threads = 1; threads <= max_threads; threads *= 2){
+        JobSystem jobs{threads};
+        Run check{count};
+        SimulationGraph graph{check.world, tree.brain, check.pool, chunk};
+        for(int f = 0; f < frames; ++f){ graph.step(jobs, dt); }
+        const bool ok = same(reference, check);
+        failures += ok ? 0 : 1;
+        const double ns = best_time_ns(reps, [&]{
+            Run r{count};
+            SimulationGraph g{r.world, tree.brain, r.pool, chunk};
+            for(int f = 0; f < frames; ++f){ g.step(jobs, dt); }
+        }) / frames;
+        std::printf("  SimulationGraph x%-4zu %10.1f us/frame  (%.2fx)%s\n", threads, ns / 1000.0, serial_ns / ns, ok ? "" : "  MISMATCH");
+        if(threads * 2 > max_threads){
+            std::printf("last frame on %zu threads:\n", threads);
+            graph.graph().print_critical_path(stdout);
+            graph.graph().print_timeline(stdout, 80);
+        }
+    }
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "spatial-order.hpp"
+
+// Morton re-sorting of the pool: what the sort costs, and what it saves in the passes that walk
+// agents by position (neighbor grid build and kernel, perception) and in the whole frame.
+// "pool stride" is the mean distance, in rows, between consecutive entries of the neighbor grid:
+// how far the grid build jumps through the pool, a proxy for its cache misses.
+// Also checks that handles, BT memory and blackboard rows follow their agent through a sort.
+static int bench_morton(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    //1. the sort itself
+    {
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        Rng rng{7};
+        std::vector<EntityHandle> handles;
+        pool.spawn(20'000, rng, &handles);
+        for(std::size_t i = 0; i < pool.size(); ++i){ pool.memory()[i].bt_mem[0] = static_cast<int>(i); }
+        struct Before final{
+            Vector2 position;
+            int tag;
+            int waypoint;
+        };
+        std::vector<Before> before;
+        for(const auto h : handles){
+            const std::size_t i = pool.index_of(h);
+            before.push_back({pool.entities()[i].position, pool.memory()[i].bt_mem[0], pool.board().get<WaypointIndex>(i)});
+        }
+        failures += pool.sort_spatially() ? 0 : 1;
+        for(std::size_t k = 0; k < handles.size(); ++k){
+            const std::size_t i = pool.index_of(handles[k]);
+            const bool same = pool.entities()[i].position.x == before[k].position.x && pool.entities()[i].position.y == before[k].position.y
+                && pool.memory()[i].bt_mem[0] == before[k].tag && pool.board().get<WaypointIndex>(i) == before[k].waypoint
+                && pool.handle_at(i) == handles[k];
+            failures += same ? 0 : 1;
+        }
+        for(std::size_t i = 1; i < pool.size(); ++i){
+            failures += (MortonOrder::key(pool.entities()[i - 1].position) <= MortonOrder::key(pool.entities()[i].position)) ? 0 : 1;
+        }
+        failures += pool.sort_spatially() ? 1 : 0; //already in order
+    }
+
+    //2. `count` agents after `frames` frames, never re-sorted vs re-sorted every resort_period frames
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    };
+    DemoTree tree;
+    auto make = [&](std::uint32_t period){
+        Run r;
+        r.world.resort_period = period;
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        for(int f = 0; f < frames; ++f){ simulate(r.world, tree.brain, r.pool, dt); }
+        return r;
+    };
+    struct Costs final{
+        double build = 0.0, flock = 0.0, perceive = 0.0, frame = 0.0, stride = 0.0;
+    };
+    auto measure = [&](Run& r){
+        const double n = static_cast<double>(count);
+        Costs c;
+        auto& grid = r.pool.neighbors();
+        c.build = best_time_ns(reps, [&]{ grid.build(r.pool.entities()); }) / n;
+        c.flock = best_time_ns(reps, [&]{ flock_rows(grid, r.world.tuning, 0, NeighborGrid::rows); }) / n;
+        c.perceive = best_time_ns(reps, [&]{ perceive(r.world, r.pool.entities(), r.pool.board(), r.pool.senses()); }) / n;
+        double jumps = 0.0;
+        for(std::size_t j = 1; j < grid.size(); ++j){ jumps += std::abs(static_cast<double>(grid.row[j]) - static_cast<double>(grid.row[j - 1])); }
+        c.stride = jumps / static_cast<double>(std::max<std::size_t>(grid.size(), 2) - 1);
+        c.frame = best_time_ns(reps, [&]{ simulate(r.world, tree.brain, r.pool, dt); }) / n;
+        return c;
+    };
+    const std::uint32_t period = World{}.resort_period;
+    Run unsorted = make(0);
+    Run sorted = make(period);
+    const Costs a = measure(unsorted);
+    const Costs b = measure(sorted);
+
+    //what a re-sort costs: from spawn order (random), and after a period of drift
+    EntityPool fresh{Blackboard{DemoTree::Keys{}}};
+    Rng rng{3};
+    fresh.spawn(count, rng);
+    const double random_sort = time_ns([&]{ std::ignore = fresh.sort_spatially(); });
+    double drift_sort = std::numeric_limits<double>::max();
+    sorted.world.resort_period = 0;
+    for(int r = 0; r < reps; ++r){
+        for(std::uint32_t f = 1; f < period; ++f){ simulate(sorted.world, tree.brain, sorted.pool, dt); }
+        drift_sort = std::min(drift_sort, time_ns([&]{ std::ignore = sorted.pool.sort_spatially(); }));
+    }
+
+    const double n = static_cast<double>(count);
+    std::printf("morton: %zu agents after %d frames, best of %d\n", count, frames, reps);
+    std::printf("  %-22s %10s %10s %10s %10s %12s\n", "ns/agent", "grid build", "flock", "perceive", "frame", "pool stride");
+    std::printf("  %-22s %10.2f %10.2f %10.2f %10.2f %12.0f\n", "never re-sorted", a.build, a.flock, a.perceive, a.frame, a.stride);
+    std::printf("  %-22s %10.2f %10.2f %10.2f %10.2f %12.0f\n", "re-sorted", b.build, b.flock, b.perceive, b.frame, b.stride);
+    std::printf("  sort: %.2f ns/agent from random order, %.2f ns/agent after %u frames of drift (%.3f ns/agent/frame amortized)\n",
+        random_sort / n, drift_sort / n, period, drift_sort / n / period);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (an agent lost its state or the order is wrong)");
+    return failures;
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include "bench.hpp"
+#include "behavior-tree.hpp"
+#include "entity-pool.hpp"
+#include <memory>
+
+// Per-node cost of the engine's node types, alone and in generated trees, printed as JSON
+// so runs can be diffed across engine changes:
+// * isolation: each node type over trivial leaves
+// * shapes:    random trees of the given depth / fanout / leaf cost, with leaf outcomes either
+//              fixed per leaf (predictable branches) or drawn on every visit (unpredictable)
+// * sizes:     trees where every tick visits every node, grown past L1/L2/L3
+namespace nodes_bench{
+    inline int leaf_cost = 0;           //iterations of dependent arithmetic per leaf visit
+    inline std::uint32_t coin = 1;      //xorshift state for random outcomes; reset before every run
+    inline std::uint64_t visits = 0;    //only counted by Counted wrappers
+
+    inline void spin() noexcept{
+        float x = 1.0f;
+        for(int i = 0; i < leaf_cost; ++i){ x = x * 1.0001f + 0.0001f; }
+        keep(x);
+    }
+    inline bool flip() noexcept{
+        coin ^= coin << 13;
+        coin ^= coin >> 17;
+        coin ^= coin << 5;
+        return (coin & 1u) != 0;
+    }
+
+    inline Status Succeed(Context&, float) noexcept{ spin(); return Status::Success; }
+    inline Status Fail(Context&, float) noexcept{ spin(); return Status::Failure; }
+    inline Status Coin(Context&, float) noexcept{ spin(); return flip() ? Status::Success : Status::Failure; }
+
+    // Counts visits while sizing a tree; the timed runs use the bare tree.
+    struct Counted final : Node{
+        Node* inner = nullptr;
+        explicit Counted(Node* n) : inner(n){}
+        Status tick(Context& ctx, float dt) const noexcept override{
+            ++visits;
+            return inner->tick(ctx, dt);
+        }
+    };
+
+    struct Synthetic final{
+        std::vector<std::unique_ptr<Node>> nodes;
+        Node* root = nullptr;
+        std::size_t bytes = 0; //nodes plus child arrays, without allocator overhead
+
+        template <typename T, typename... A>
+        Node* make(bool counted, A&&... args){
+            auto n = std::make_unique<T>(std::forward<A>(args)...);
+            bytes += sizeof(T);
+            if constexpr(requires{ n->children; }){ bytes += n->children.capacity() * sizeof(Node*); }
+            Node* raw = n.get();
+            nodes.push_back(std::move(n));
+            if(!counted) return raw;
+            nodes.push_back(std::make_unique<Counted>(raw));
+            return nodes.back().get();
+        }
+        std::size_t node_count(bool counted) const noexcept{ return counted ? nodes.size() / 2 : nodes.size(); }
+    };
+
+    struct Shape final{
+        int depth = 4;
+        int fanout = 4;
+        bool random_outcomes = false;
+        bool all_visited = false; //only Sequences of succeeding leaves: every tick walks the whole tree
+        std::uint64_t seed = 1;
+    };
+
+    inline Node* generate(const Shape& shape, int depth, Rng& rng, Synthetic& t, bool counted){
+        if(depth == 0){
+            const bool heads = rng.range(0, 1) != 0; //drawn in every mode, so both outcome modes build the same shape
+            if(shape.all_visited) return t.make<Leaf>(counted, Succeed);
+            if(shape.random_outcomes) return t.make<Leaf>(counted, Coin);
+            return t.make<Leaf>(counted, heads ? Succeed : Fail);
+        }
+        const int roll = shape.all_visited ? 0 : rng.range(0, 99);
+        if(roll >= 95){
+            Node* child = generate(shape, depth - 1, rng, t, counted);
+            return t.make<RepeatForever>(counted, child);
+        }
+        std::vector<Node*> kids;
+        for(int i = 0; i < shape.fanout; ++i){ kids.push_back(generate(shape, depth - 1, rng, t, counted)); }
+        if(roll < 40) return t.make<Sequence>(counted, std::move(kids));
+        if(roll < 80) return t.make<Selector>(counted, std::move(kids));
+        return t.make<MemorySequence>(counted, rng.range(0, 7), std::move(kids));
+    }
+
+    inline Synthetic build(const Shape& shape, bool counted){
+        Synthetic t;
+        Rng rng{shape.seed};
+        t.root = generate(shape, shape.depth, rng, t, counted);
+        return t;
+    }
+
+    struct Harness final{
+        World world;
+        EntityPool pool;
+        Harness(){
+            Rng rng{1};
+            pool.spawn(1, rng);
+        }
+        Context context() noexcept{
+            return Context{pool.entities()[0], pool.memory()[0], world, pool.board(), pool.senses(), 0};
+        }
+        void run(const Node& root, int ticks) noexcept{
+            Context ctx = context();
+            coin = 0x9E3779B9u;
+            pool.memory()[0].bt_mem = {};
+            for(int i = 0; i < ticks; ++i){ std::ignore = root.tick(ctx, 0.0f); }
+        }
+    };
+
+    // ns per visit of `timed`; visits are counted on `counted`, an identical tree with wrappers.
+    inline double ns_per_visit(Harness& h, const Node& timed, const Node& counted, int ticks, int reps, std::uint64_t* visits_out = nullptr){
+        visits = 0;
+        h.run(counted, ticks);
+        const std::uint64_t v = visits;
+        if(visits_out){ *visits_out = v; }
+        const double ns = best_time_ns(reps, [&]{ h.run(timed, ticks); });
+        return ns / static_cast<double>(std::max<std::uint64_t>(v, 1));
+    }
+}
+
+static int bench_nodes(Args args){
+    using namespace nodes_bench;
+    const int depth = static_cast<int>(arg_or(args, "depth", 6));
+    const int fanout = static_cast<int>(arg_or(args, "fanout", 4));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    const auto max_nodes = static_cast<std::size_t>(arg_or(args, "max-nodes", 6'000'000));
+    const auto seed = static_cast<std::uint64_t>(arg_or(args, "seed", 1));
+    leaf_cost = static_cast<int>(arg_or(args, "leaf-cost", 0));
+    Harness h;
+
+    std::printf("{\n  \"benchmark\": \"nodes\",\n  \"simd\": \"%s\",\n", simd::backend);
+    std::printf("  \"config\": {\"depth\": %d, \"fanout\": %d, \"leaf_cost\": %d, \"reps\": %d, \"seed\": %llu},\n",
+        depth, fanout, leaf_cost, reps, static_cast<unsigned long long>(seed));
+
+    //isolation: one composite over 8 trivial leaves, ticked many times
+    {
+        constexpr int ticks = 200'000;
+        constexpr int width = 8;
+        Leaf ok{Succeed}, no{Fail};
+        Counted cok{&ok}, cno{&no};
+        std::vector<Node*> oks(width, &ok), nos(width, &no), coks(width, &cok), cnos(width, &cno);
+        Sequence seq{oks}, cseq_inner{coks};
+        Selector sel{nos}, csel_inner{cnos};
+        MemorySequence mem{0, oks}, cmem_inner{0, coks};
+        RepeatForever rep{&ok}, crep_inner{&cok};
+        Counted cseq{&cseq_inner}, csel{&csel_inner}, cmem{&cmem_inner}, crep{&crep_inner};
+        struct Case final{ const char* name; const Node& timed; const Node& counted; int leaves; };
+        const Case cases[] = {
+            {"Leaf", ok, cok, 1},
+            {"Sequence", seq, cseq, width},
+            {"Selector", sel, csel, width},
+            {"MemorySequence", mem, cmem, width},
+            {"RepeatForever", rep, crep, 1},
+        };
+        const double leaf_ns = ns_per_visit(h, ok, cok, ticks, reps);
+        std::printf("  \"isolation\": [\n");
+        for(std::size_t i = 0; i < std::size(cases); ++i){
+            const auto& c = cases[i];
+            std::uint64_t v = 0;
+            const double per_visit = ns_per_visit(h, c.timed, c.counted, ticks, reps, &v);
+            const double per_tick = per_visit * static_cast<double>(v) / ticks;
+            const double own = (c.leaves == 1 && i == 0) ? per_tick : per_tick - leaf_ns * c.leaves; //the composite's own share
+            std::printf("    {\"node\": \"%s\", \"children\": %d, \"ns_per_tick\": %.3f, \"ns_per_visit\": %.3f, \"ns_own\": %.3f}%s\n",
+                c.name, (i == 0) ? 0 : c.leaves, per_tick, per_visit, own, (i + 1 < std::size(cases)) ? "," : "");
+        }
+        std::printf("  ],\n");
+    }
+
+    //shapes: the same random tree with predictable vs unpredictable leaf outcomes
+    {
+        std::printf("  \"shapes\": [\n");
+        bool first = true;
+        for(int d = 2; d <= depth; d += 2){
+            for(const bool random : {false, true}){
+                Shape shape{d, fanout, random, false, seed};
+                const Synthetic timed = build(shape, false);
+                const Synthetic counted = build(shape, true);
+                const int ticks = 20'000;
+                std::uint64_t v = 0;
+                const double per_visit = ns_per_visit(h, *timed.root, *counted.root, ticks, reps, &v);
+                std::printf("%s    {\"depth\": %d, \"fanout\": %d, \"outcomes\": \"%s\", \"nodes\": %zu, \"bytes\": %zu, \"visits_per_tick\": %.1f, \"ns_per_visit\": %.3f}",
+                    first ? "" : ",\n", d, fanout, random ? "random" : "constant", timed.node_count(false), timed.bytes,
+                    static_cast<double>(v) / ticks, per_visit);
+                first = false;
+            }
+        }
+        std::printf("\n  ],\n");
+    }
+
+    //sizes: every node visited every tick, tree footprint from a few KB to past L3 (--max-nodes caps it)
+    {
+        std::printf("  \"sizes\": [\n");
+        bool first = true;
+        for(int d = 2;; ++d){
+            Shape shape{d, 4, false, true, seed};
+            std::size_t nodes = 0;
+            for(std::size_t level = 0, w = 1; level <= static_cast<std::size_t>(d); ++level, w *= 4){ nodes += w; }
+            if(nodes > max_nodes) break;
+            const Synthetic timed = build(shape, false);
+            const int ticks = static_cast<int>(std::max<std::size_t>(1, 2'000'000 / nodes));
+            const double ns = best_time_ns(std::min(reps, 3), [&]{ h.run(*timed.root, ticks); });
+            const double per_visit = ns / (static_cast<double>(nodes) * ticks); //every node, every tick
+            std::printf("%s    {\"nodes\": %zu, \"bytes\": %zu, \"ns_per_visit\": %.3f}", first ? "" : ",\n", nodes, timed.bytes, per_visit);
+            first = false;
+        }
+        std::printf("\n  ]\n}\n");
+    }
+    return 0;
+}
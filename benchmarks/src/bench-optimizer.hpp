@@ -0,0 +1,94 @@
+#pragma once
+#include "bench.hpp"
+#include "game-ai.hpp"
+#include "tree-optimizer.hpp"
+
+static Status WolfActive(Context& ctx, float) noexcept{
+    return ctx.world.wolf_active ? Status::Success : Status::Failure;
+}
+
+static Status Idle(Context& ctx, float) noexcept{
+    ctx.self.activity = Activity::None;
+    return Status::Running;
+}
+
+// DemoTree as it might be written by hand: the threat check wrapped in its own Sequence,
+// the rarely-failing wolf check first, and a fallback after the patrol loop that can never run.
+struct UntunedTree final{
+    using Keys = DemoTree::Keys;
+
+    Leaf wolfActive{WolfActive, condition("WolfActive", reads_world(WorldInput::WolfActive))};
+    Leaf threat{ThreatNearby, condition_writing("ThreatNearby", threat_inputs, reads_key<ThreatSafeUntil>)};
+    Sequence sensing{&wolfActive, &threat};
+    Leaf flee{DoFlee, action("DoFlee", outcome(Status::Running))};
+    Sequence fleeSeq{&sensing, &flee};
+
+    Leaf moveToCorner{MoveToCorner, action("MoveToCorner", outcome(Status::Success) | outcome(Status::Running))};
+    Leaf advanceCorner{AdvanceCorner, action("AdvanceCorner", outcome(Status::Success))};
+    MemorySequence patrolSeq{0, {&moveToCorner, &advanceCorner}};
+    RepeatForever patrolLoop{&patrolSeq};
+
+    Leaf hungry{CheckHunger, condition("CheckHunger", reads_key<IsHungry>)};
+    Leaf seekFood{DoSeekFood, action("DoSeekFood", outcome(Status::Success) | outcome(Status::Running))};
+    Sequence foodSeq{&hungry, &seekFood};
+
+    Leaf idle{Idle, action("Idle", outcome(Status::Running))};
+    Selector root{&fleeSeq, &foodSeq, &patrolLoop, &idle};
+    EntityBrain brain{&root};
+};
+
+static void print_indented(const std::string& text){
+    std::size_t start = 0;
+    while(start < text.size()){
+        const auto end = text.find('\n', start);
+        std::printf("    %.*s\n", static_cast<int>(end - start), text.data() + start);
+        start = end + 1;
+    }
+}
+
+// Optimizes DemoTree and UntunedTree against a recorded workload, verifies the traces,
+// and compares tick cost before and after.
+static int bench_optimizer(Args args){
+    Workload workload{Blackboard{DemoTree::Keys{}}};
+    workload.agents = static_cast<std::size_t>(arg_or(args, "count", 2'000));
+    workload.frames = static_cast<int>(arg_or(args, "frames", 1'200));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    int failures = 0;
+
+    auto run = [&](const char* label, Node& root, const EntityBrain& original){
+        TreeGraph graph = TreeGraph::from(root);
+        std::printf("%s, before:\n", label);
+        print_indented(graph.describe());
+        const TreeProfile profile = record_profile(graph, workload);
+        optimize(graph, profile);
+        const BuiltTree optimized = build(graph);
+        std::printf("%s, after:\n", label);
+        print_indented(graph.describe());
+
+        const int diverged = verify_trace(original, optimized.brain, workload);
+        failures += (diverged < 0) ? 0 : 1;
+        auto time_brain = [&](const EntityBrain& brain){
+            return best_time_ns(reps, [&]{
+                Replay replay(workload);
+                for(int f = 0; f < workload.frames; ++f){ replay.step(brain); }
+                keep(replay.population.entities()[0]);
+            });
+        };
+        const double visits = static_cast<double>(workload.agents) * workload.frames;
+        const double before_ns = time_brain(original) / visits;
+        const double after_ns = time_brain(optimized.brain) / visits;
+        if(diverged < 0){
+            std::printf("  trace: identical over %d frames x %zu agents\n", workload.frames, workload.agents);
+        } else{
+            std::printf("  trace: DIVERGED at frame %d\n", diverged);
+        }
+        std::printf("  simulate: %.2f -> %.2f ns/agent/frame\n\n", before_ns, after_ns);
+    };
+
+    DemoTree demo;
+    run("DemoTree", demo.root, demo.brain);
+    UntunedTree untuned;
+    run("UntunedTree", untuned.root, untuned.brain);
+    std::printf("checks %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
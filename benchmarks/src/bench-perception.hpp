@@ -0,0 +1,69 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+
+// The batched perception pass vs sensing agent by agent with the scalar helpers (what the
+// leaves used to do on their own), on open ground and with obstacles. Also checks that the
+// cached senses match the scalar ones.
+static int bench_perception(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int reps = static_cast<int>(arg_or(args, "reps", 20));
+    int failures = 0;
+
+    World world;
+    EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    Rng rng{3};
+    pool.spawn(count, rng);
+    const auto entities = pool.entities();
+    const auto& board = pool.board();
+    auto& senses = pool.senses();
+
+    auto scalar_pass = [&](std::vector<Sense>& out){
+        out.resize(count * 3);
+        for(std::size_t i = 0; i < count; ++i){
+            const Vector2 p = entities[i].position;
+            const int w = board.get<WaypointIndex>(i);
+            out[i * 3 + 0] = sense(p, world.wolf_pos, world.wolf_field);
+            out[i * 3 + 1] = sense(p, world.food_pos, world.food_field);
+            out[i * 3 + 2] = sense(p, world.waypoints[w], world.waypoint_fields[w]);
+        }
+    };
+    //|batch - scalar| relative to the distance, and absolute on the unit directions
+    auto max_error = [&](const std::vector<Sense>& ref){
+        float err = 0.0f;
+        for(std::size_t i = 0; i < count; ++i){
+            const Sense got[3] = {senses.threat[i], senses.food[i], senses.waypoint[i]};
+            for(int k = 0; k < 3; ++k){
+                const Sense& want = ref[i * 3 + k];
+                if(k == 0 && want.dist >= World::danger_radius) continue; //threat directions are only routed inside the danger radius
+                err = std::max(err, std::abs(got[k].dist - want.dist) / std::max(want.dist, 1.0f));
+                err = std::max(err, Vector2Length(got[k].dir - want.dir));
+            }
+        }
+        return err;
+    };
+
+    std::vector<Sense> ref;
+    std::printf("perception: %zu agents, best of %d, %s\n", count, reps, simd::backend);
+    std::printf("%-12s %14s %14s %12s\n", "ground", "batch ns/agt", "scalar ns/agt", "max error");
+    auto run = [&](const char* label){
+        const double batch_ns = best_time_ns(reps, [&]{ perceive(world, entities, board, senses); keep(senses.food.dist[count / 2]); });
+        const double scalar_ns = best_time_ns(reps, [&]{ scalar_pass(ref); keep(ref[count / 2]); });
+        const float err = max_error(ref);
+        failures += (err <= 1e-5f) ? 0 : 1;
+        const double n = static_cast<double>(count);
+        std::printf("%-12s %14.2f %14.2f %12.2e\n", label, batch_ns / n, scalar_ns / n, err);
+    };
+    run("open");
+
+    world.add_obstacle({300.0f, 100.0f, 40.0f, 400.0f});
+    world.add_obstacle({700.0f, 250.0f, 40.0f, 470.0f});
+    world.add_obstacle({900.0f, 80.0f, 250.0f, 40.0f});
+    for(int f = 0; f < 64; ++f){ world.update(0.0f); } //let every field finish its time-sliced rebuild
+    run("obstacles");
+
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "frame-pipeline.hpp"
+#include <thread>
+
+// Bit-exact comparison of two populations, field by field (memcmp would also compare Entity's padding).
+static bool same_agents(std::span<const Entity> a, std::span<const Entity> b) noexcept{
+    if(a.size() != b.size()) return false;
+    auto same = [](const auto& x, const auto& y){ return std::memcmp(&x, &y, sizeof(x)) == 0; };
+    for(std::size_t i = 0; i < a.size(); ++i){
+        if(!same(a[i].position, b[i].position) || !same(a[i].velocity, b[i].velocity) || !same(a[i].acceleration, b[i].acceleration)
+            || a[i].activity != b[i].activity) return false;
+    }
+    return true;
+}
+
+// Stand-in for the draw calls: builds the triangle of every agent into a vertex buffer, the way
+// raylib's batcher does, `passes` times over. Headless, so there is no GPU to wait on.
+static void draw_snapshot(const RenderSnapshot& frame, std::vector<Vector2>& vertices, int passes) noexcept{
+    const std::size_t n = frame.size();
+    vertices.resize(n * 3);
+    for(int pass = 0; pass < passes; ++pass){
+        for(std::size_t i = 0; i < n; ++i){
+            const Vector2 p = {frame.pos_x[i], frame.pos_y[i]};
+            const Vector2 x = Vector2{frame.heading_x[i], frame.heading_y[i]} * ENTITY_SIZE;
+            const Vector2 y = {-x.y, x.x};
+            vertices[i * 3 + 0] = p + x * 1.4f;
+            vertices[i * 3 + 1] = p - x - y;
+            vertices[i * 3 + 2] = p - x + y;
+        }
+        keep(vertices[n / 2]);
+    }
+}
+
+// The demo's frame loop, headless: simulate + capture + draw back to back on one thread, vs
+// drawing frame N while a FrameWorker simulates N+1. Also checks that both loops produce the
+// same simulation.
+static int bench_pipeline(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 20'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 300));
+    const int passes = static_cast<int>(arg_or(args, "draw-passes", 8));
+    const int reps = static_cast<int>(arg_or(args, "reps", 3));
+    const float dt = 1.0f / 60.0f;
+    DemoTree tree;
+
+    struct Run final{
+        World world;
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        std::array<RenderSnapshot, 2> snapshots;
+        std::vector<Vector2> vertices;
+        explicit Run(std::size_t count){
+            Rng rng{11};
+            pool.spawn(count, rng);
+            world.rng = Rng{12};
+            snapshots[0].capture(world, pool);
+        }
+    };
+
+    auto sequential = [&](Run& r){
+        for(int f = 0; f < frames; ++f){
+            simulate(r.world, tree.brain, r.pool, dt);
+            r.snapshots[0].capture(r.world, r.pool);
+            draw_snapshot(r.snapshots[0], r.vertices, passes);
+        }
+    };
+    FrameWorker worker;
+    auto pipelined = [&](Run& r){
+        std::size_t front = 0;
+        for(int f = 0; f < frames; ++f){
+            RenderSnapshot& back = r.snapshots[front ^ 1];
+            worker.kick([&]{
+                simulate(r.world, tree.brain, r.pool, dt);
+                back.capture(r.world, r.pool);
+            });
+            draw_snapshot(r.snapshots[front], r.vertices, passes);
+            worker.wait();
+            front ^= 1;
+        }
+        draw_snapshot(r.snapshots[front], r.vertices, passes); //the last simulated frame, so both loops draw `frames` frames
+    };
+
+    //the parts on their own
+    double sim_ns = 0.0, capture_ns = 0.0, draw_ns = 0.0;
+    {
+        Run r{count};
+        sim_ns = best_time_ns(reps, [&]{ simulate(r.world, tree.brain, r.pool, dt); });
+        capture_ns = best_time_ns(reps, [&]{ r.snapshots[0].capture(r.world, r.pool); });
+        draw_ns = best_time_ns(reps, [&]{ draw_snapshot(r.snapshots[0], r.vertices, passes); });
+    }
+    const double sequential_ns = best_time_ns(reps, [&]{ Run r{count}; sequential(r); }) / frames;
+    const double pipelined_ns = best_time_ns(reps, [&]{ Run r{count}; pipelined(r); }) / frames;
+
+    //same seeds, same number of steps: the two loops must end on bit-identical agents
+    int failures = 0;
+    {
+        Run a{count}, b{count};
+        sequential(a);
+        pipelined(b);
+        failures += same_agents(a.pool.entities(), b.pool.entities()) ? 0 : 1;
+    }
+
+    std::printf("pipeline: %zu agents x %d frames, %d draw passes, best of %d, %u hardware threads\n",
+        count, frames, passes, reps, std::thread::hardware_concurrency());
+    std::printf("  simulate          %10.1f us\n", sim_ns / 1000.0);
+    std::printf("  capture snapshot  %10.1f us\n", capture_ns / 1000.0);
+    std::printf("  draw (stand-in)   %10.1f us\n", draw_ns / 1000.0);
+    std::printf("  sequential frame  %10.1f us  (sum of the parts: %.1f)\n", sequential_ns / 1000.0, (sim_ns + capture_ns + draw_ns) / 1000.0);
+    std::printf("  pipelined frame   %10.1f us  (max of the parts: %.1f, %.2fx)\n", pipelined_ns / 1000.0,
+        std::max(sim_ns + capture_ns, draw_ns) / 1000.0, sequential_ns / pipelined_ns);
+    std::printf("  checks            %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
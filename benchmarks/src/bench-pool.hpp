@@ -0,0 +1,63 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+
+// Bulk spawn vs one-at-a-time spawning through raylib's RNG, and despawn churn.
+// Also checks that handles, per-entity BT memory and blackboard rows survive swap-remove compaction.
+static int bench_pool(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int reps = static_cast<int>(arg_or(args, "reps", 10));
+    int failures = 0;
+
+    const double raylib_ns = best_time_ns(reps, [&]{
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        for(std::size_t i = 0; i < count; ++i){
+            Entity e;
+            e.position = random_range(ZERO, STAGE_SIZE);
+            e.velocity = vector_from_angle(random_range(0.0f, 2.0f * PI), Entity::min_speed);
+            std::ignore = pool.spawn(e);
+            pool.board().get<Hunger>(i).value = random_range(0.0f, 1.0f);
+            pool.board().get<WaypointIndex>(i) = GetRandomValue(0, 3);
+        }
+        keep(pool.entities()[count / 2]);
+    });
+    const double bulk_ns = best_time_ns(reps, [&]{
+        EntityPool pool{Blackboard{DemoTree::Keys{}}};
+        Rng rng{42};
+        pool.spawn(count, rng);
+        keep(pool.entities()[count / 2]);
+    });
+
+    //churn: despawn half at random, respawn them, and verify the survivors
+    EntityPool pool{Blackboard{DemoTree::Keys{}}};
+    Rng rng{7};
+    std::vector<EntityHandle> handles;
+    pool.spawn(count, rng, &handles);
+    for(std::size_t i = 0; i < count; ++i){
+        pool.memory()[i].bt_mem[0] = static_cast<int>(handles[i].slot); //tag each agent's BT memory with its own slot
+        pool.board().get<WaypointIndex>(i) = static_cast<int>(handles[i].slot); //and its blackboard row
+    }
+    shuffle(std::span(handles));
+    const auto half = handles.size() / 2;
+    const double despawn_ns = time_ns([&]{
+        for(std::size_t i = 0; i < half; ++i){ failures += pool.despawn(handles[i]) ? 0 : 1; }
+    });
+    for(std::size_t i = 0; i < half; ++i){ failures += pool.alive(handles[i]) ? 1 : 0; } //stale handles must be dead
+    for(std::size_t i = half; i < handles.size(); ++i){
+        const auto slot = static_cast<int>(handles[i].slot);
+        const bool intact = pool.alive(handles[i]) && pool.memory()[pool.index_of(handles[i])].bt_mem[0] == slot
+            && pool.board().get<WaypointIndex>(pool.index_of(handles[i])) == slot;
+        failures += intact ? 0 : 1;
+    }
+    pool.spawn(half, rng);
+    failures += (pool.size() == count && pool.board().size() == count) ? 0 : 1;
+
+    const double n = static_cast<double>(count);
+    std::printf("pool: %zu agents, best of %d\n", count, reps);
+    std::printf("  spawn one by one, raylib RNG %8.2f ns/agent\n", raylib_ns / n);
+    std::printf("  bulk spawn, Rng              %8.2f ns/agent  (%.1fx)\n", bulk_ns / n, raylib_ns / bulk_ns);
+    std::printf("  despawn (swap-remove)        %8.2f ns/agent\n", despawn_ns / static_cast<double>(half));
+    std::printf("  handle/memory checks         %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
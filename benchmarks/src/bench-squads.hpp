@@ -0,0 +1,126 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+#include "squad.hpp"
+
+// DemoTree for every agent vs squads: SquadTree once per squad plus MemberTree per agent. The two
+// make different decisions (a squad flees as one), so there is no lockstep; instead the run
+// checks that the squads hold together, cover every agent, and order every member within the
+// threat radius to flee. "tick" is everything between
+// perception and integration; for squads that includes regrouping, sensing the squads and
+// publishing their directives, which is also shown on its own.
+static int bench_squads(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    auto integrate = [&](World& world, EntityPool& pool, bool flocking){
+        auto entities = pool.entities();
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            if(flocking){ flock(pool.neighbors(), entities[i], i); }
+            entities[i].update(dt);
+        }
+        apply_commands(world, pool, {&world.commands, 1});
+    };
+
+    World solo_world;
+    solo_world.rng = Rng{9};
+    EntityPool solo{Blackboard{DemoTree::Keys{}}};
+    World squad_world;
+    squad_world.rng = Rng{9};
+    EntityPool members{Blackboard{MemberTree::Keys{}}};
+    {
+        Rng rng{3};
+        solo.spawn(count, rng);
+        Rng again{3};
+        members.spawn(count, again);
+    }
+    DemoTree tree;
+    SquadTree squad_tree;
+    MemberTree member_tree;
+    Squads squads;
+
+    double solo_ns = 0.0, squad_ns = 0.0, member_ns = 0.0;
+    double squad_count = 0.0, formed = 0.0, dissolved = 0.0, strays = 0.0;
+    std::array<std::size_t, 4> solo_activity{}, member_activity{};
+    std::size_t advances = 0;
+    std::size_t unwarned = 0; //members within the threat radius whose squad did not order them to flee
+    std::vector<int> corner;
+    for(int f = 0; f < frames; ++f){
+        bool flocking = prepare_step(solo_world, solo, dt);
+        solo_ns += time_ns([&]{
+            auto entities = solo.entities();
+            auto memory = solo.memory();
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], solo_world, solo.board(), solo.senses(), i, &solo_world.commands};
+                std::ignore = tree.brain.tick(ctx, dt);
+            }
+        });
+        integrate(solo_world, solo, flocking);
+
+        flocking = prepare_step(squad_world, members, dt);
+        squad_ns += time_ns([&]{ squads.tick(squad_world, squad_tree.brain, members, dt); });
+        for(std::size_t i = 0; i < members.size(); ++i){ //members do not look for the wolf: their squad must have
+            if(members.senses().threat.dist[i] >= squad_world.tuning.threat_radius) continue;
+            unwarned += (members.board().get<SquadDirective>(i).order == Activity::Flee) ? 0 : 1;
+        }
+        member_ns += time_ns([&]{
+            auto entities = members.entities();
+            auto memory = members.memory();
+            for(std::size_t i = 0; i < entities.size(); ++i){
+                Context ctx{entities[i], memory[i], squad_world, members.board(), members.senses(), i, &squad_world.commands};
+                std::ignore = member_tree.brain.tick(ctx, dt);
+            }
+        });
+        integrate(squad_world, members, flocking);
+
+        //every agent in a live squad, every squad within its size limit and all sizes adding up
+        std::size_t total = 0;
+        auto& board = squads.pool.board();
+        for(std::size_t s = 0; s < squads.pool.size(); ++s){
+            const auto size = board.get<SquadFormation>(s).size;
+            failures += (size <= Squads::capacity) ? 0 : 1; //0: emptied this frame, dissolved on the next
+            total += size;
+        }
+        for(const auto h : members.board().column<SquadOf>()){ failures += squads.pool.alive(h) ? 0 : 1; }
+        failures += (total == count) ? 0 : 1;
+        failures += (unwarned == 0) ? 0 : 1;
+        if(failures > 0){
+            std::printf("  squads broken at frame %d\n", f);
+            break;
+        }
+
+        //waypoints reached: a squad that is still there with a different corner than last frame
+        const auto now = board.column<WaypointIndex>();
+        for(std::size_t s = 0; s < std::min(corner.size(), now.size()); ++s){ advances += (corner[s] != now[s]) ? 1 : 0; }
+        corner.assign(now.begin(), now.end());
+
+        squad_count += static_cast<double>(squads.pool.size());
+        formed += static_cast<double>(squads.formed());
+        dissolved += static_cast<double>(squads.dissolved());
+        strays += static_cast<double>(squads.strays());
+        for(const auto& e : solo.entities()){ ++solo_activity[static_cast<std::size_t>(e.activity)]; }
+        for(const auto& e : members.entities()){ ++member_activity[static_cast<std::size_t>(e.activity)]; }
+    }
+
+    const double agent_frames = static_cast<double>(count) * frames;
+    auto mix = [&](const std::array<std::size_t, 4>& a){
+        std::printf("  flee %5.1f %%  patrol %5.1f %%  seek food %5.1f %%\n", 100.0 * a[1] / agent_frames, 100.0 * a[2] / agent_frames, 100.0 * a[3] / agent_frames);
+    };
+    std::printf("squads: %zu agents x %d frames\n", count, frames);
+    std::printf("  %.0f squads on average (%.1f agents each, at most %u); per frame %.1f formed, %.1f dissolved, %.1f agents strayed\n",
+        squad_count / frames, agent_frames / squad_count, Squads::capacity, formed / frames, dissolved / frames, strays / frames);
+    std::printf("  squad waypoints reached: %zu\n", advances);
+    std::printf("  %-22s %8.2f ns/agent tick  %8.0f decision trees per frame\n", "DemoTree per agent", solo_ns / agent_frames, static_cast<double>(count));
+    std::printf("  %-22s %8.2f ns/agent tick  %8.0f decision trees per frame  (squads %.2f, members %.2f)\n", "squads",
+        (squad_ns + member_ns) / agent_frames, squad_count / frames, squad_ns / agent_frames, member_ns / agent_frames);
+    std::printf("  DemoTree per agent:");
+    mix(solo_activity);
+    std::printf("  squads:            ");
+    mix(member_activity);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (an agent is outside every squad, a squad is over capacity, or a member near the wolf was not told to flee)");
+    return failures;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "bench.hpp"
+#include "steering.hpp"
+#include "steering-batch.hpp"
+
+// Scalar steer_* over an array of Entity vs the SoA batch kernels in steering-batch.hpp.
+// Also verifies the documented error bound (batch_steering_tolerance) on the same input.
+struct SteeringData final{
+    std::vector<float> px, py, vx, vy, ax, ay;
+    std::vector<Entity> entities;
+
+    explicit SteeringData(std::size_t n)
+        : px(random_floats(n, 0.0f, STAGE_SIZE.x, 1)), py(random_floats(n, 0.0f, STAGE_SIZE.y, 2)),
+        vx(random_floats(n, -Entity::max_speed, Entity::max_speed, 3)), vy(random_floats(n, -Entity::max_speed, Entity::max_speed, 4)),
+        ax(n, 0.0f), ay(n, 0.0f), entities(n){
+        px[0] = STAGE_SIZE.x * 0.5f; py[0] = STAGE_SIZE.y * 0.5f; //one agent sitting exactly on the target/threat
+        for(std::size_t i = 0; i < n; ++i){
+            entities[i].position = {px[i], py[i]};
+            entities[i].velocity = {vx[i], vy[i]};
+            entities[i].acceleration = ZERO;
+        }
+    }
+
+    SteeringBatch batch() noexcept{
+        return {px, py, vx, vy, ax, ay};
+    }
+
+    void clear() noexcept{
+        std::fill(ax.begin(), ax.end(), 0.0f);
+        std::fill(ay.begin(), ay.end(), 0.0f);
+        for(auto& e : entities){ e.acceleration = ZERO; }
+    }
+
+    // Largest error relative to the documented bound; <= 1.0 means within tolerance.
+    float worst_error(float max_speed, float weight) const noexcept{
+        float worst = 0.0f;
+        for(std::size_t i = 0; i < entities.size(); ++i){
+            const Vector2 a = entities[i].acceleration;
+            const float bound = batch_steering_tolerance * weight * (max_speed + Vector2Length(entities[i].velocity));
+            worst = std::max({worst, std::abs(a.x - ax[i]) / bound, std::abs(a.y - ay[i]) / bound});
+        }
+        return worst;
+    }
+};
+
+static int bench_steering(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int reps = static_cast<int>(arg_or(args, "reps", 50));
+    const Vector2 target = STAGE_SIZE * 0.5f;
+    const float speed = Entity::max_speed;
+    SteeringData d(count);
+    int failures = 0;
+
+    std::printf("steering: %zu agents, best of %d, simd backend %s (%zu lanes)\n", count, reps, simd::backend, simd::width);
+    std::printf("%-14s %12s %12s %9s %12s\n", "kernel", "scalar ns/e", "batch ns/e", "speedup", "err/bound");
+
+    auto report = [&](const char* name, auto scalar_fn, auto batch_fn, float weight){
+        d.clear();
+        scalar_fn();
+        auto b = d.batch();
+        batch_fn(b);
+        const float err = d.worst_error(speed, weight);
+        failures += (err > 1.0f) ? 1 : 0;
+        const double scalar_ns = best_time_ns(reps, scalar_fn) / to_float(static_cast<int>(count));
+        const double batch_ns = best_time_ns(reps, [&]{ auto bb = d.batch(); batch_fn(bb); }) / to_float(static_cast<int>(count));
+        keep(d.ax[count / 2]);
+        std::printf("%-14s %12.3f %12.3f %8.2fx %12.3f%s\n", name, scalar_ns, batch_ns, scalar_ns / batch_ns, err, err > 1.0f ? "  FAIL" : "");
+    };
+
+    report("seek+drag",
+        [&]{ for(auto& e : d.entities){ e.acceleration += steer_seek(e, target, speed); e.acceleration += steer_drag(e); } },
+        [&](SteeringBatch& b){ steer_seek(b, target, speed); steer_drag(b); },
+        Entity::seek_weight);
+    report("flee+drag",
+        [&]{ for(auto& e : d.entities){ e.acceleration += steer_flee(e, target, speed); e.acceleration += steer_drag(e); } },
+        [&](SteeringBatch& b){ steer_flee(b, target, speed); steer_drag(b); },
+        Entity::flee_weight);
+    return failures;
+}
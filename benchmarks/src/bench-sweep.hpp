@@ -0,0 +1,57 @@
+#pragma once
+#include "bench.hpp"
+#include "sweep.hpp"
+#include <string>
+
+// Headless tuning driver: scores Tunings of DemoTree's constants with batched simulations
+// and writes them ranked, as CSV. --mode=grid|random|evolve, --out=file.csv (default: top 10 to stdout).
+static int bench_sweep(Args args){
+    SweepConfig config;
+    config.batch.agents = static_cast<std::size_t>(arg_or(args, "agents", 50));
+    config.batch.frames = static_cast<int>(arg_or(args, "frames", 600));
+    config.batch.seed = static_cast<std::uint64_t>(arg_or(args, "seed", 1));
+    config.seeds = static_cast<std::size_t>(arg_or(args, "seeds", 4));
+    const std::string_view mode = arg_text(args, "mode", "evolve");
+    const std::string_view out = arg_text(args, "out", "");
+    const auto threads = static_cast<std::size_t>(arg_or(args, "threads", std::max(1u, std::thread::hardware_concurrency())));
+    DemoTree tree;
+    JobSystem jobs{threads};
+    Rng rng{static_cast<std::uint64_t>(arg_or(args, "seed", 1)), 7};
+
+    std::vector<SweepResult> ranked;
+    std::size_t evaluated = 0;
+    const double ns = time_ns([&]{
+        if(mode == "grid"){
+            const auto candidates = grid(Tuning{}, static_cast<std::size_t>(arg_or(args, "steps", 3)));
+            ranked = evaluate(jobs, tree.brain, candidates, config);
+            rank(ranked);
+        } else if(mode == "random"){
+            const auto candidates = random_tunings(static_cast<std::size_t>(arg_or(args, "count", 512)), rng);
+            ranked = evaluate(jobs, tree.brain, candidates, config);
+            rank(ranked);
+        } else{
+            ranked = evolve(jobs, tree.brain, config, static_cast<std::size_t>(arg_or(args, "population", 64)),
+                static_cast<int>(arg_or(args, "generations", 8)), rng);
+        }
+        evaluated = ranked.size();
+    });
+    const Tuning defaults{};
+    const auto baseline = evaluate(jobs, tree.brain, {&defaults, 1}, config).front();
+
+    std::printf("sweep (%.*s): %zu configurations x %zu seeds x %zu agents x %d frames on %zu threads\n",
+        static_cast<int>(mode.size()), mode.data(), evaluated, config.seeds, config.batch.agents, config.batch.frames, jobs.thread_count());
+    std::printf("  %.1f s, %.0f configurations/minute\n", ns / 1e9, evaluated / (ns / 6e10));
+    std::printf("  defaults: fitness %.4f (survival %.4f, food rate %.3f)\n", baseline.fitness, baseline.survival, baseline.food_rate);
+    if(!out.empty()){
+        std::FILE* f = std::fopen(std::string(out).c_str(), "w");
+        if(!f){
+            std::fprintf(stderr, "cannot write '%.*s'\n", static_cast<int>(out.size()), out.data());
+            return 1;
+        }
+        write_ranked(f, ranked);
+        std::fclose(f);
+        std::printf("  wrote %zu ranked results to %.*s\n", ranked.size(), static_cast<int>(out.size()), out.data());
+    }
+    write_ranked(stdout, ranked, 10);
+    return 0;
+}
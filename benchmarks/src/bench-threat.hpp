@@ -0,0 +1,92 @@
+#pragma once
+#include "bench.hpp"
+#include "entity-pool.hpp"
+#include "game-ai.hpp"
+#include "simulation.hpp"
+
+// ThreatSafeUntil: how many threat distance checks the speed-limit bound skips, and whether the
+// decisions stay exactly those of a tree that measures every agent every frame. The wolf is
+// toggled and moved by hand now and then, which must invalidate the bounds.
+using UnboundedKeys = KeySet<WaypointIndex, IsHungry, Hunger>; //DemoTree::Keys without ThreatSafeUntil
+
+static int bench_threat(Args args){
+    const auto count = static_cast<std::size_t>(arg_or(args, "count", 100'000));
+    const int frames = static_cast<int>(arg_or(args, "frames", 600));
+    const int reps = static_cast<int>(arg_or(args, "reps", 5));
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+
+    struct Run final{
+        World world;
+        EntityPool pool;
+        explicit Run(Blackboard board) : pool(std::move(board)){}
+    };
+    auto make = [&](Blackboard board){
+        Run r{std::move(board)};
+        r.world.rng = Rng{9};
+        Rng rng{3};
+        r.pool.spawn(count, rng);
+        return r;
+    };
+    auto disturb = [](World& w){ //the cases the epoch must catch
+        if(w.frame % 240 == 120){ w.set_wolf_active(!w.wolf_active); }
+        if(w.frame % 300 == 299){ w.place_wolf(w.rng.range(ZERO, STAGE_SIZE)); }
+    };
+
+    DemoTree tree;
+    Run bounded = make(Blackboard{DemoTree::Keys{}});
+    Run reference = make(Blackboard{UnboundedKeys{}});
+    std::size_t safe_rows = 0, safe_blocks = 0, blocks = 0, checked_frames = 0;
+    for(int f = 0; f < frames; ++f){
+        disturb(bounded.world);
+        disturb(reference.world);
+        if(bounded.world.wolf_active){ //what the next step's perception pass and ThreatNearby will skip
+            const float next = bounded.world.time + dt;
+            const auto& board = bounded.pool.board();
+            for(std::size_t i = 0; i < count; i += simd::width){
+                bool all = true;
+                for(std::size_t k = i; k < std::min(count, i + simd::width); ++k){
+                    const bool safe = board.get<ThreatSafeUntil>(k).holds(next, bounded.world.threat_epoch);
+                    safe_rows += safe ? 1 : 0;
+                    all = all && safe;
+                }
+                safe_blocks += all ? 1 : 0;
+                ++blocks;
+            }
+            ++checked_frames;
+        }
+        simulate(bounded.world, tree.brain, bounded.pool, dt);
+        simulate(reference.world, tree.brain, reference.pool, dt);
+        const auto a = bounded.pool.entities(), b = reference.pool.entities();
+        for(std::size_t i = 0; i < count; ++i){
+            failures += (a[i].activity == b[i].activity && a[i].position.x == b[i].position.x && a[i].position.y == b[i].position.y) ? 0 : 1;
+        }
+        if(failures > 0){
+            std::printf("  decisions diverge at frame %d\n", f);
+            break;
+        }
+    }
+
+    auto frame_ns = [&](Run& r){
+        return best_time_ns(reps, [&]{
+            disturb(r.world);
+            simulate(r.world, tree.brain, r.pool, dt);
+        }) / static_cast<double>(count);
+    };
+    auto perceive_ns = [&](Run& r){
+        return best_time_ns(reps, [&]{ perceive(r.world, r.pool.entities(), r.pool.board(), r.pool.senses()); }) / static_cast<double>(count);
+    };
+    const double bounded_ns = frame_ns(bounded);
+    const double reference_ns = frame_ns(reference);
+    const double bounded_perceive = perceive_ns(bounded);
+    const double reference_perceive = perceive_ns(reference);
+
+    const double agent_frames = static_cast<double>(count) * std::max<std::size_t>(checked_frames, 1);
+    std::printf("threat: %zu agents x %d frames, wolf toggled every 240 frames and moved every 300\n", count, frames);
+    std::printf("  ThreatNearby checks skipped   %6.1f %%  (wolf active)\n", 100.0 * safe_rows / agent_frames);
+    std::printf("  perception blocks skipped     %6.1f %%  (%zu-wide)\n", 100.0 * safe_blocks / static_cast<double>(std::max<std::size_t>(blocks, 1)), simd::width);
+    std::printf("  %-28s %8.2f ns/agent  perceive %6.2f ns/agent\n", "measured every frame", reference_ns, reference_perceive);
+    std::printf("  %-28s %8.2f ns/agent  perceive %6.2f ns/agent\n", "ThreatSafeUntil", bounded_ns, bounded_perceive);
+    std::printf("  checks %s\n", failures == 0 ? "ok" : "FAILED (the bound changed a decision)");
+    return failures;
+}
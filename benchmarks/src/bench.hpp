@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Tiny benchmark harness shared by the bench-*.hpp files.
+// No framework on purpose: every benchmark is a plain function that prints its own table.
+
+using Args = std::span<const std::string_view>;
+
+struct Benchmark final{
+    std::string_view name;
+    std::string_view description;
+    int(*run)(Args args);
+};
+
+// Keeps the optimizer from discarding results we never otherwise read.
+inline const void* volatile bench_sink = nullptr;
+
+template <typename T>
+inline void keep(const T& value) noexcept{
+    bench_sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+// Single timed run, for work that cannot be repeated (e.g. despawning a given set of agents).
+template <typename Fn>
+inline double time_ns(Fn&& fn){
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+}
+
+// Runs fn() `reps` times after one warm-up call and returns the best wall time in nanoseconds.
+// Best-of-N is less noisy than the mean on a desktop that is doing other things.
+template <typename Fn>
+inline double best_time_ns(int reps, Fn&& fn){
+    using clock = std::chrono::steady_clock;
+    fn();
+    double best = std::numeric_limits<double>::max();
+    for(int r = 0; r < reps; ++r){
+        const auto start = clock::now();
+        fn();
+        const auto end = clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return best;
+}
+
+inline std::vector<float> random_floats(std::size_t count, float min, float max, unsigned seed){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(min, max);
+    std::vector<float> out(count);
+    for(auto& x : out){ x = dist(rng); }
+    return out;
+}
+
+// "--name=value" lookup with a fallback. Keeps argument parsing out of the benchmarks themselves.
+inline long long arg_or(Args args, std::string_view name, long long fallback) noexcept{
+    for(auto a : args){
+        if(a.size() > name.size() + 3 && a.starts_with("--") && a.substr(2, name.size()) == name && a[name.size() + 2] == '='){
+            return std::atoll(a.substr(name.size() + 3).data());
+        }
+    }
+    return fallback;
+}
+
+// The same for text options, e.g. --mode=grid. The view points into the original argument.
+inline std::string_view arg_text(Args args, std::string_view name, std::string_view fallback) noexcept{
+    for(auto a : args){
+        if(a.size() > name.size() + 3 && a.starts_with("--") && a.substr(2, name.size()) == name && a[name.size() + 2] == '='){
+            return a.substr(name.size() + 3);
+        }
+    }
+    return fallback;
+}
@@ -0,0 +1,77 @@
+/**
+ * Behavior Trees Demo - benchmarks
+ * -------------
+ * Headless micro-benchmarks for the engine in behavior_trees/src.
+ * Usage: benchmarks <name> [--option=value ...]    (no name lists the benchmarks)
+ *
+ * Copyright (c) 2026, Ulf Benjaminsson
+ */
+#include "bench.hpp"
+#include "bench-steering.hpp"
+#include "bench-flowfield.hpp"
+#include "bench-entity-layout.hpp"
+#include "bench-pool.hpp"
+#include "bench-coroutine.hpp"
+#include "bench-perception.hpp"
+#include "bench-optimizer.hpp"
+#include "bench-cache.hpp"
+#include "bench-nodes.hpp"
+#include "bench-flat.hpp"
+#include "bench-pipeline.hpp"
+#include "bench-jobs.hpp"
+#include "bench-batch.hpp"
+#include "bench-sweep.hpp"
+#include "bench-hunger.hpp"
+#include "bench-threat.hpp"
+#include "bench-flock.hpp"
+#include "bench-morton.hpp"
+#include "bench-buckets.hpp"
+#include "bench-decisions.hpp"
+#include "bench-batch-leaves.hpp"
+#include "bench-squads.hpp"
+#include "bench-far-field.hpp"
+#include "bench-arena.hpp"
+
+static constexpr Benchmark benchmarks[] = {
+	{"steering", "scalar vs SIMD seek/flee/drag  [--count=N --reps=N]", bench_steering},
+	{"flowfield", "flow field rebuild and sampling cost  [--count=N --reps=N]", bench_flowfield},
+	{"entity-layout", "legacy Entity vs hot/cold split, one frame  [--count=N --reps=N]", bench_entity_layout},
+	{"pool", "bulk spawn, despawn churn, handle checks  [--count=N --reps=N]", bench_pool},
+	{"coroutine", "pooled coroutine leaf vs function leaf  [--count=N --frames=N --reps=N]", bench_coroutine},
+	{"perception", "batched perception pass vs per-agent sensing  [--count=N --reps=N]", bench_perception},
+	{"optimizer", "profile-guided tree optimizer, trace verification  [--count=N --frames=N --reps=N]", bench_optimizer},
+	{"cache", "subtree result caching on a condition-heavy tree  [--count=N --frames=N --reps=N]", bench_cache},
+	{"nodes", "per-node cost, random tree shapes and sizes, as JSON  [--depth=N --fanout=N --leaf-cost=N --max-nodes=N --seed=N --reps=N]", bench_nodes},
+	{"flat", "node-per-object trees vs FlatTree: memory, build, tick  [--max-nodes=N --reps=N]", bench_flat},
+	{"pipeline", "sequential frame vs drawing N while simulating N+1  [--count=N --frames=N --draw-passes=N --reps=N]", bench_pipeline},
+	{"jobs", "simulate() vs the task-graph frame on 1..N threads, critical path  [--count=N --frames=N --chunk=N --threads=N --reps=N]", bench_jobs},
+	{"batch", "many independent worlds on 1..N threads, aggregate stats  [--instances=N --agents=N --frames=N --seed=N --threads=N]", bench_batch},
+	{"sweep", "tune DemoTree's constants, ranked CSV  [--mode=grid|random|evolve --out=F --agents=N --frames=N --seeds=N --steps=N --count=N --population=N --generations=N --threads=N]", bench_sweep},
+	{"hunger", "per-frame hunger integration vs scheduled threshold crossings  [--count=N --frames=N --reps=N]", bench_hunger},
+	{"threat", "skipped threat checks from speed-limit bounds, lockstep decision check  [--count=N --frames=N --reps=N]", bench_threat},
+	{"flock", "separation/alignment/cohesion over the neighbor grid, 60 Hz budget  [--count=N --frames=N --reps=N]", bench_flock},
+	{"morton", "Morton re-sort of the pool: sort cost, grid/perception/frame before and after  [--count=N --frames=N --reps=N]", bench_morton},
+	{"buckets", "DemoTree ticked in row order vs grouped by last frame's branch, lockstep check  [--count=N --frames=N --resort=N]", bench_buckets},
+	{"decisions", "DemoTree's root decision by traversal vs guard bitmasks + lookup table, lockstep check  [--count=N --frames=N]", bench_decisions},
+	{"leaves", "DemoTree ticked per agent vs per node with batch leaf functions, lockstep check, leaf by leaf  [--count=N --frames=N]", bench_batch_leaves},
+	{"squads", "DemoTree per agent vs a squad tree per group plus a short member tree per agent  [--count=N --frames=N]", bench_squads},
+	{"farfield", "everyone in full vs a coarse model for agents away from the wolf, the viewer and the food  [--count=N --frames=N --view=R]", bench_far_field},
+	{"arena", "operator new calls in the steady-state frame, every way of stepping the simulation  [--count=N --frames=N --warmup=N --threads=N]", bench_arena},
+};
+
+int main(int argc, char** argv){
+	std::vector<std::string_view> args(argv + 1, argv + argc);
+	if(args.empty()){
+		for(const auto& b : benchmarks){
+			std::printf("  %-12s %s\n", b.name.data(), b.description.data());
+		}
+		return 0;
+	}
+	for(const auto& b : benchmarks){
+		if(b.name == args.front()){
+			return b.run(Args(args).subspan(1));
+		}
+	}
+	std::fprintf(stderr, "unknown benchmark '%s'\n", args.front().data());
+	return 1;
+}